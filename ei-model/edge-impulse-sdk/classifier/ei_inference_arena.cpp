@@ -0,0 +1,235 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "edge-impulse-sdk/classifier/ei_inference_arena.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+#define ARENA_ALIGN             8
+#define ARENA_NO_BLOCK          0xffffffff
+#define ARENA_BLOCK_FREED       (1 << 0)
+#define ARENA_BLOCK_ROUTED      (1 << 1)
+
+// header in front of every block, blocks are popped in LIFO order once freed
+typedef struct {
+    uint32_t prev_block;    // offset of the block below, ARENA_NO_BLOCK for the first one
+    uint32_t flags;
+} arena_block_t;
+
+static uint8_t arena[EI_CLASSIFIER_INFERENCE_ARENA_SIZE] __attribute__((aligned(ARENA_ALIGN)));
+static uint32_t arena_base = 0;     // everything below was still in use at the end of an inference
+static uint32_t arena_top = 0;
+static uint32_t arena_last_block = ARENA_NO_BLOCK;
+static uint32_t arena_reserved_last_block = ARENA_NO_BLOCK; // top of the blocks below arena_base
+static uint32_t arena_reserved_live = 0;
+static uint32_t arena_hwm = 0;
+static uint32_t arena_routed_live = 0;
+static uint32_t arena_heap_fallbacks = 0;
+static int arena_depth = 0;
+static int arena_paused = 0;
+static void *arena_owner = nullptr;
+
+__attribute__((weak)) void *ei_inference_arena_owner(void)
+{
+    return nullptr;
+}
+
+static void *arena_alloc(size_t size, uint32_t flags)
+{
+    size_t needed = sizeof(arena_block_t) + ((size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1));
+
+    if (needed > EI_CLASSIFIER_INFERENCE_ARENA_SIZE - arena_top) {
+        return nullptr;
+    }
+
+    arena_block_t *block = (arena_block_t*)&arena[arena_top];
+    block->prev_block = arena_last_block;
+    block->flags = flags;
+
+    arena_last_block = arena_top;
+    arena_top += needed;
+    if (arena_top > arena_hwm) {
+        arena_hwm = arena_top;
+    }
+
+    return block + 1;
+}
+
+void ei_inference_arena_begin(void)
+{
+    if (arena_depth++ > 0) {
+        return;
+    }
+
+    arena_top = arena_base;
+    arena_last_block = ARENA_NO_BLOCK;
+    arena_routed_live = 0;
+    arena_owner = ei_inference_arena_owner();
+}
+
+void ei_inference_arena_end(void)
+{
+    if (--arena_depth > 0) {
+        return;
+    }
+
+    if (arena_routed_live > 0) {
+        // someone kept a scratch allocation, keep that memory out of the next inferences
+        // until it's freed. Everything else in it is only needed until the next begin.
+        ei_printf("WARN: %u arena allocation(s) outlived the inference, %u bytes reserved\n",
+            (unsigned int)arena_routed_live, (unsigned int)(arena_top - arena_base));
+
+        uint32_t ix = arena_last_block;
+        while (ix != ARENA_NO_BLOCK) {
+            arena_block_t *block = (arena_block_t*)&arena[ix];
+            if (!(block->flags & ARENA_BLOCK_ROUTED)) {
+                block->flags |= ARENA_BLOCK_FREED;
+            }
+            if (block->prev_block == ARENA_NO_BLOCK) {
+                // chain onto the blocks reserved earlier
+                block->prev_block = arena_reserved_last_block;
+                break;
+            }
+            ix = block->prev_block;
+        }
+
+        arena_reserved_last_block = arena_last_block;
+        arena_reserved_live += arena_routed_live;
+        arena_base = arena_top;
+        arena_last_block = ARENA_NO_BLOCK;
+        arena_routed_live = 0;
+    }
+}
+
+void ei_inference_arena_reset(void)
+{
+    if (arena_depth > 0) {
+        return;
+    }
+
+    arena_base = 0;
+    arena_top = 0;
+    arena_last_block = ARENA_NO_BLOCK;
+    arena_reserved_last_block = ARENA_NO_BLOCK;
+    arena_reserved_live = 0;
+    arena_routed_live = 0;
+}
+
+void *ei_inference_arena_calloc(size_t nitems, size_t size)
+{
+    if (arena_depth == 0) {
+        return nullptr;
+    }
+
+    void *ptr = arena_alloc(nitems * size, 0);
+    if (ptr) {
+        memset(ptr, 0, nitems * size);
+    }
+    return ptr;
+}
+
+void *ei_inference_arena_try_malloc(size_t size)
+{
+    if (arena_depth == 0 || arena_paused > 0 || ei_inference_arena_owner() != arena_owner) {
+        return nullptr;
+    }
+
+    void *ptr = arena_alloc(size, ARENA_BLOCK_ROUTED);
+    if (ptr) {
+        arena_routed_live++;
+    }
+    else {
+        arena_heap_fallbacks++;
+    }
+    return ptr;
+}
+
+bool ei_inference_arena_free(void *ptr)
+{
+    if ((uint8_t*)ptr < arena || (uint8_t*)ptr >= arena + sizeof(arena)) {
+        return false;
+    }
+
+    arena_block_t *block = (arena_block_t*)ptr - 1;
+    if (block->flags & ARENA_BLOCK_FREED) {
+        return true;
+    }
+    block->flags |= ARENA_BLOCK_FREED;
+
+    if ((uint8_t*)block < arena + arena_base) {
+        // reserved by ei_inference_arena_end(), or left over from a previous inference
+        if ((block->flags & ARENA_BLOCK_ROUTED) && arena_reserved_live > 0) {
+            arena_reserved_live--;
+        }
+
+        // lower the base down to the highest reserved block still in use
+        while (arena_reserved_last_block != ARENA_NO_BLOCK) {
+            arena_block_t *last = (arena_block_t*)&arena[arena_reserved_last_block];
+            if (!(last->flags & ARENA_BLOCK_FREED)) {
+                break;
+            }
+            arena_base = arena_reserved_last_block;
+            arena_reserved_last_block = last->prev_block;
+        }
+        return true;
+    }
+    if (block->flags & ARENA_BLOCK_ROUTED) {
+        arena_routed_live--;
+    }
+
+    // release the freed blocks on top of the stack
+    while (arena_last_block != ARENA_NO_BLOCK) {
+        arena_block_t *last = (arena_block_t*)&arena[arena_last_block];
+        if (!(last->flags & ARENA_BLOCK_FREED)) {
+            break;
+        }
+        arena_top = arena_last_block;
+        arena_last_block = last->prev_block;
+    }
+
+    return true;
+}
+
+void ei_inference_arena_pause(bool pause)
+{
+    arena_paused += pause ? 1 : -1;
+}
+
+void ei_inference_arena_get_stats(ei_inference_arena_stats_t *stats)
+{
+    stats->size = EI_CLASSIFIER_INFERENCE_ARENA_SIZE;
+    stats->used = arena_top;
+    stats->high_water_mark = arena_hwm;
+    stats->heap_fallbacks = arena_heap_fallbacks;
+}
@@ -0,0 +1,146 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EI_CLASSIFIER_INFERENCE_ARENA_H_
+#define _EI_CLASSIFIER_INFERENCE_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "model-parameters/model_metadata.h"
+
+/**
+ * Static arena for the allocations made while an impulse runs. It's reset at the start
+ * of every process_impulse() call, memory handed out stays valid until the next one
+ * (e.g. result->_raw_outputs).
+ *
+ * Allocations made by process_impulse() itself always come from the arena. Ports that
+ * route ei_malloc() / ei_calloc() through ei_inference_arena_try_malloc() (and ei_free()
+ * through ei_inference_arena_free()) also serve the DSP and inference scratch buffers
+ * from it, and fall back to the heap only when the arena is full.
+ */
+
+#ifndef EI_CLASSIFIER_INFERENCE_ARENA_DSP_COPIES
+// number of raw input frames the DSP blocks keep as scratch at the same time
+#define EI_CLASSIFIER_INFERENCE_ARENA_DSP_COPIES    2
+#endif
+
+#ifndef EI_CLASSIFIER_INFERENCE_ARENA_SIZE
+#ifdef EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE
+#define EI_CLASSIFIER_INFERENCE_ARENA_NN_SIZE       (EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE + 64)
+#else
+#define EI_CLASSIFIER_INFERENCE_ARENA_NN_SIZE       0
+#endif
+#define EI_CLASSIFIER_INFERENCE_ARENA_SIZE          (EI_CLASSIFIER_INFERENCE_ARENA_NN_SIZE + \
+                                                     EI_CLASSIFIER_INFERENCE_ARENA_DSP_COPIES * EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE * sizeof(float) + \
+                                                     4 * EI_CLASSIFIER_NN_INPUT_FRAME_SIZE * sizeof(float) + \
+                                                     1024)
+#endif
+
+typedef struct {
+    size_t size;            // arena size in bytes
+    size_t used;            // bytes in use at the end of the last inference
+    size_t high_water_mark; // peak usage over all inferences
+    uint32_t heap_fallbacks; // routed allocations that didn't fit and went to the heap
+} ei_inference_arena_stats_t;
+
+/**
+ * Start / end an inference. Starting resets the arena, calls may be nested.
+ */
+void ei_inference_arena_begin(void);
+void ei_inference_arena_end(void);
+
+/**
+ * Drop everything in the arena, including blocks reserved by ei_inference_arena_end()
+ * because they outlived their inference. Only when no inference runs, and nothing
+ * may hold on to arena memory anymore (run_classifier_init() / run_classifier_deinit()).
+ */
+void ei_inference_arena_reset(void);
+
+/**
+ * Zeroed memory for process_impulse(), valid until the next ei_inference_arena_begin()
+ * @return nullptr if the arena is full or no inference is running
+ */
+void *ei_inference_arena_calloc(size_t nitems, size_t size);
+
+/**
+ * Hook for the port's ei_malloc(), only serves the task that started the inference
+ * @return nullptr if the allocation should go to the heap
+ */
+void *ei_inference_arena_try_malloc(size_t size);
+
+/**
+ * Hook for the port's ei_free(). Once all blocks reserved at the end of an inference
+ * are freed, their memory goes back to the arena.
+ * @return true if ptr belongs to the arena (and must not be passed to the heap)
+ */
+bool ei_inference_arena_free(void *ptr);
+
+/**
+ * Keep allocations out of the arena, for buffers that live across inferences
+ */
+void ei_inference_arena_pause(bool pause);
+
+/**
+ * Identifies the caller (e.g. the RTOS task), so other tasks allocating while an
+ * inference runs don't end up in the arena. Weak, returns nullptr by default.
+ */
+void *ei_inference_arena_owner(void);
+
+void ei_inference_arena_get_stats(ei_inference_arena_stats_t *stats);
+
+#ifdef __cplusplus
+namespace ei {
+
+/**
+ * Scope of an inference, ends it on every return path
+ */
+class InferenceArenaScope {
+public:
+    InferenceArenaScope() { ei_inference_arena_begin(); }
+    ~InferenceArenaScope() { ei_inference_arena_end(); }
+};
+
+/**
+ * Allocations in this scope go to the heap, e.g. lazily created state
+ */
+class InferenceArenaBypass {
+public:
+    InferenceArenaBypass() { ei_inference_arena_pause(true); }
+    ~InferenceArenaBypass() { ei_inference_arena_pause(false); }
+};
+
+} // namespace ei
+#endif // __cplusplus
+
+#endif // _EI_CLASSIFIER_INFERENCE_ARENA_H_
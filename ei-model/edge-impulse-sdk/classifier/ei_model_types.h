@@ -39,6 +39,7 @@
 
 #include "edge-impulse-sdk/classifier/ei_classifier_types.h"
 #include "edge-impulse-sdk/dsp/ei_dsp_handle.h"
+#include "edge-impulse-sdk/classifier/ei_inference_arena.h"
 #include "edge-impulse-sdk/dsp/numpy.hpp"
 #if EI_CLASSIFIER_USE_FULL_TFLITE || (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_AKIDA) || (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_MEMRYX)
 #include "tensorflow-lite/tensorflow/lite/c/common.h"
@@ -455,6 +456,8 @@ public:
 
     DspHandle* get_dsp_handle(size_t ix) {
         if (dsp_handles[ix] == nullptr) {
+            // the handle keeps state between inferences, don't create it in the inference arena
+            ei::InferenceArenaBypass bypass;
             dsp_handles[ix] = impulse->dsp_blocks[ix].factory(impulse->dsp_blocks[ix].config, impulse->frequency);
         }
         return dsp_handles[ix];
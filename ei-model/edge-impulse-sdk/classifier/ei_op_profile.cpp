@@ -0,0 +1,265 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "edge-impulse-sdk/classifier/ei_op_profile.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+#include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated.h"
+
+static ei_op_profile_entry_t profile_ops[EI_CLASSIFIER_PROFILE_OPS_MAX];
+static size_t profile_ops_count = 0;
+static ei_op_profile_invoke_t profile_invoke;
+static uint32_t invoke_start_cycles = 0;
+static uint64_t invoke_start_us = 0;
+
+__attribute__((weak)) uint32_t ei_op_profile_read_cycles(void)
+{
+    return 0;
+}
+
+void ei_op_profile_invoke_begin(void)
+{
+    invoke_start_us = ei_read_timer_us();
+    invoke_start_cycles = ei_op_profile_read_cycles();
+}
+
+void ei_op_profile_invoke_end(void)
+{
+    uint32_t cycles = ei_op_profile_read_cycles() - invoke_start_cycles;
+
+    profile_invoke.invokes++;
+    profile_invoke.cycles += cycles;
+    profile_invoke.time_us += ei_read_timer_us() - invoke_start_us;
+}
+
+void ei_op_profile_record(size_t op, const char *name, uint32_t macs, uint32_t arena_bytes,
+                          uint32_t cycles, uint32_t time_us)
+{
+    if (op >= EI_CLASSIFIER_PROFILE_OPS_MAX) {
+        return;
+    }
+
+    ei_op_profile_entry_t *entry = &profile_ops[op];
+    entry->name = name;
+    entry->macs = macs;
+    entry->arena_bytes = arena_bytes;
+    entry->calls++;
+    entry->cycles += cycles;
+    entry->time_us += time_us;
+
+    if (op >= profile_ops_count) {
+        profile_ops_count = op + 1;
+    }
+}
+
+static const char *op_name(const TfLiteRegistration *registration)
+{
+    if (registration->builtin_code == tflite::BuiltinOperator_CUSTOM) {
+        return registration->custom_name ? registration->custom_name : "CUSTOM";
+    }
+    return tflite::EnumNameBuiltinOperator((tflite::BuiltinOperator)registration->builtin_code);
+}
+
+static const TfLiteTensor *node_tensor(TfLiteContext *context, const TfLiteIntArray *tensors, int ix)
+{
+    if (ix >= tensors->size || tensors->data[ix] < 0) {
+        return nullptr;
+    }
+    return context->GetTensor(context, tensors->data[ix]);
+}
+
+static uint32_t tensor_elements(const TfLiteTensor *tensor)
+{
+    uint32_t elements = 1;
+    for (int ix = 0; ix < tensor->dims->size; ix++) {
+        elements *= tensor->dims->data[ix];
+    }
+    return elements;
+}
+
+/**
+ * Every output element accumulates the part of the filter it sees:
+ * fully connected [units, depth], conv [out_ch, h, w, in_ch], depthwise [1, h, w, out_ch]
+ */
+static uint32_t node_macs(TfLiteContext *context, const TfLiteNode *node, int32_t builtin_code)
+{
+    if (builtin_code != tflite::BuiltinOperator_FULLY_CONNECTED &&
+        builtin_code != tflite::BuiltinOperator_CONV_2D &&
+        builtin_code != tflite::BuiltinOperator_DEPTHWISE_CONV_2D) {
+        return 0;
+    }
+
+    const TfLiteTensor *filter = node_tensor(context, node->inputs, 1);
+    const TfLiteTensor *output = node_tensor(context, node->outputs, 0);
+    if (!filter || !output || filter->dims->size < 2) {
+        return 0;
+    }
+
+    const TfLiteIntArray *dims = filter->dims;
+    uint32_t per_output;
+    if (builtin_code == tflite::BuiltinOperator_FULLY_CONNECTED) {
+        per_output = dims->data[dims->size - 1];
+    }
+    else if (builtin_code == tflite::BuiltinOperator_CONV_2D) {
+        per_output = tensor_elements(filter) / dims->data[0];
+    }
+    else {
+        per_output = tensor_elements(filter) / dims->data[dims->size - 1];
+    }
+    return tensor_elements(output) * per_output;
+}
+
+static uint32_t node_arena_bytes(TfLiteContext *context, const TfLiteNode *node)
+{
+    uint32_t bytes = 0;
+    const TfLiteIntArray *lists[] = { node->inputs, node->outputs };
+
+    for (const TfLiteIntArray *tensors : lists) {
+        for (int ix = 0; ix < tensors->size; ix++) {
+            const TfLiteTensor *tensor = node_tensor(context, tensors, ix);
+            if (tensor && tensor->allocation_type == kTfLiteArenaRw) {
+                bytes += tensor->bytes;
+            }
+        }
+    }
+    return bytes;
+}
+
+TfLiteStatus ei_op_profile_invoke(TfLiteContext *context, TfLiteNode *node,
+                                  const TfLiteRegistration *registration, size_t op)
+{
+    uint64_t start_us = ei_read_timer_us();
+    uint32_t start_cycles = ei_op_profile_read_cycles();
+
+    TfLiteStatus status = registration->invoke(context, node);
+
+    uint32_t cycles = ei_op_profile_read_cycles() - start_cycles;
+    uint32_t time_us = (uint32_t)(ei_read_timer_us() - start_us);
+
+    // shapes don't change between invokes, only look at the tensors on the first call
+    if (op < EI_CLASSIFIER_PROFILE_OPS_MAX && profile_ops[op].calls > 0) {
+        const ei_op_profile_entry_t *entry = &profile_ops[op];
+        ei_op_profile_record(op, entry->name, entry->macs, entry->arena_bytes, cycles, time_us);
+    }
+    else {
+        ei_op_profile_record(op, op_name(registration),
+            node_macs(context, node, registration->builtin_code),
+            node_arena_bytes(context, node), cycles, time_us);
+    }
+
+    return status;
+}
+
+size_t ei_op_profile_get(const ei_op_profile_entry_t **entries, ei_op_profile_invoke_t *invoke)
+{
+    if (entries) {
+        *entries = profile_ops;
+    }
+    if (invoke) {
+        *invoke = profile_invoke;
+    }
+    return profile_ops_count;
+}
+
+void ei_op_profile_reset(void)
+{
+    memset(profile_ops, 0, sizeof(profile_ops));
+    memset(&profile_invoke, 0, sizeof(profile_invoke));
+    profile_ops_count = 0;
+}
+
+void ei_op_profile_print(void)
+{
+    if (profile_invoke.invokes == 0) {
+        ei_printf("No profile recorded, run the impulse first\n");
+        return;
+    }
+
+    uint64_t ops_cycles = 0;
+    uint64_t ops_us = 0;
+
+    ei_printf("Per-op profile, average of %lu invokes:\n", (unsigned long)profile_invoke.invokes);
+    ei_printf("  #  op                     cycles      us        MACs  arena bytes\n");
+    for (size_t ix = 0; ix < profile_ops_count; ix++) {
+        const ei_op_profile_entry_t *entry = &profile_ops[ix];
+        uint32_t calls = entry->calls > 0 ? entry->calls : 1;
+
+        ei_printf("%3u  %-20s %8lu %7lu %11lu %12lu\n",
+            (unsigned)ix,
+            entry->name ? entry->name : "?",
+            (unsigned long)(entry->cycles / calls),
+            (unsigned long)(entry->time_us / calls),
+            (unsigned long)entry->macs,
+            (unsigned long)entry->arena_bytes);
+
+        ops_cycles += entry->cycles / calls;
+        ops_us += entry->time_us / calls;
+    }
+
+    uint64_t total_cycles = profile_invoke.cycles / profile_invoke.invokes;
+    uint64_t total_us = profile_invoke.time_us / profile_invoke.invokes;
+
+    ei_printf("     %-20s %8lu %7lu\n", "invoke total", (unsigned long)total_cycles, (unsigned long)total_us);
+    ei_printf("     %-20s %8lu %7lu\n", "overhead",
+        (unsigned long)(total_cycles > ops_cycles ? total_cycles - ops_cycles : 0),
+        (unsigned long)(total_us > ops_us ? total_us - ops_us : 0));
+}
+
+#else
+
+// disabled: no table, so the profiler costs no RAM
+
+size_t ei_op_profile_get(const ei_op_profile_entry_t **entries, ei_op_profile_invoke_t *invoke)
+{
+    if (entries) {
+        *entries = nullptr;
+    }
+    if (invoke) {
+        memset(invoke, 0, sizeof(*invoke));
+    }
+    return 0;
+}
+
+void ei_op_profile_reset(void)
+{
+}
+
+void ei_op_profile_print(void)
+{
+    ei_printf("Per-op profile not available, build with EI_CLASSIFIER_PROFILE_OPS=1\n");
+}
+
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
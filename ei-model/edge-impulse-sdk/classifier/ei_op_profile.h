@@ -0,0 +1,113 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EI_CLASSIFIER_OP_PROFILE_H_
+#define _EI_CLASSIFIER_OP_PROFILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Per-operator profile of the EON compiled model. With EI_CLASSIFIER_PROFILE_OPS=1 the
+ * compiled invoke loop records every kernel call through ei_op_profile_invoke(), the numbers accumulate over inferences
+ * until ei_op_profile_reset() is called.
+ */
+
+#ifndef EI_CLASSIFIER_PROFILE_OPS
+#define EI_CLASSIFIER_PROFILE_OPS               0
+#endif
+
+#ifndef EI_CLASSIFIER_PROFILE_OPS_MAX
+#define EI_CLASSIFIER_PROFILE_OPS_MAX           64
+#endif
+
+typedef struct {
+    const char *name;       // builtin operator name, e.g. "FULLY_CONNECTED"
+    uint32_t macs;          // multiply-accumulates per call, 0 for ops without
+    uint32_t arena_bytes;   // bytes of arena tensors read and written per call
+    uint32_t calls;
+    uint64_t cycles;        // summed over all calls, 0 if the port has no cycle counter
+    uint64_t time_us;       // summed over all calls
+} ei_op_profile_entry_t;
+
+typedef struct {
+    uint32_t invokes;
+    uint64_t cycles;        // whole model invoke, includes the overhead between ops
+    uint64_t time_us;
+} ei_op_profile_invoke_t;
+
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+
+/**
+ * Called by inference_tflite_run() around model_invoke()
+ */
+void ei_op_profile_invoke_begin(void);
+void ei_op_profile_invoke_end(void);
+
+/**
+ * Called by ei_op_profile_invoke() after every kernel, op is the node index
+ */
+void ei_op_profile_record(size_t op, const char *name, uint32_t macs, uint32_t arena_bytes,
+                          uint32_t cycles, uint32_t time_us);
+
+/**
+ * Runs one kernel of the EON compiled invoke loop and records it, in place of
+ * registration->invoke(context, node). The op name comes from registration->builtin_code
+ * (or custom_name), MACs and arena bytes from the node's tensors. The compiled model has
+ * to be patched once after every export, see tools/op-profile.
+ */
+TfLiteStatus ei_op_profile_invoke(TfLiteContext *context, TfLiteNode *node,
+                                  const TfLiteRegistration *registration, size_t op);
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
+
+/**
+ * Cycle counter of the port, only differences between two reads are used so it may
+ * wrap. Weak, returns 0 by default (cycles are then reported as 0).
+ */
+uint32_t ei_op_profile_read_cycles(void);
+
+/**
+ * Without EI_CLASSIFIER_PROFILE_OPS these are no-ops and there is no table
+ * @return number of entries, indexed by node
+ */
+size_t ei_op_profile_get(const ei_op_profile_entry_t **entries, ei_op_profile_invoke_t *invoke);
+void ei_op_profile_reset(void);
+
+/**
+ * Print a table with the averages per call, one line per op
+ */
+void ei_op_profile_print(void);
+
+#endif // _EI_CLASSIFIER_OP_PROFILE_H_
@@ -48,6 +48,7 @@
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/porting/ei_logging.h"
 #include <memory>
+#include <new>
 
 #if EI_CLASSIFIER_LOAD_ANOMALY_H
 #include "inferencing_engines/anomaly.h"
@@ -196,62 +197,112 @@ extern "C" EI_IMPULSE_ERROR run_inference(
     return EI_IMPULSE_OK;
 }
 
+/**
+ * @brief      Print how much of the inference arena is used
+ */
+__attribute__((unused)) static void print_inference_arena_stats(void)
+{
+    ei_inference_arena_stats_t stats;
+    ei_inference_arena_get_stats(&stats);
+
+    ei_printf("Inference arena: %u of %u bytes used, peak %u, heap fallbacks %u\n",
+        (unsigned int)stats.used, (unsigned int)stats.size,
+        (unsigned int)stats.high_water_mark, (unsigned int)stats.heap_fallbacks);
+}
+
+#if (EIDSP_USE_Q15_SPECTRAL == 1 || EIDSP_USE_Q15_MFE == 1) && EIDSP_USE_CMSIS_DSP == 1
+#define EI_CLASSIFIER_HAS_Q15_DSP 1
+typedef int (*extract_fn_q15_t)(signal_i16_t *signal, matrix_t *output_matrix, void *config, const float frequency);
+
+/**
+ * @brief      Fixed point version of a DSP block that runs on int16 samples, see
+ *             extract_spectral_analysis_features_q15() and extract_mfe_features_q15()
+ *
+ * @return     nullptr if the block has to run in float
+ */
+static extract_fn_q15_t get_extract_fn_q15(const ei_impulse_t *impulse, const ei_model_dsp_t *block)
+{
+    if (block->factory != nullptr || block->axes_size != impulse->raw_samples_per_frame) {
+        return nullptr;
+    }
+#if EIDSP_USE_Q15_SPECTRAL == 1
+    if (block->extract_fn == &extract_spectral_analysis_features &&
+        spectral::feature_q15::is_supported((ei_dsp_config_spectral_analysis_t *)block->config)) {
+        return &extract_spectral_analysis_features_q15;
+    }
+#endif // EIDSP_USE_Q15_SPECTRAL == 1
+#if EIDSP_USE_Q15_MFE == 1
+    if (block->extract_fn == &extract_mfe_features &&
+        speechpy::feature_q15::is_supported((ei_dsp_config_mfe_t *)block->config)) {
+        return &extract_mfe_features_q15;
+    }
+#endif // EIDSP_USE_Q15_MFE == 1
+    return nullptr;
+}
+#else
+#define EI_CLASSIFIER_HAS_Q15_DSP 0
+#endif // (EIDSP_USE_Q15_SPECTRAL == 1 || EIDSP_USE_Q15_MFE == 1) && EIDSP_USE_CMSIS_DSP == 1
+
 /**
  * @brief      Process a complete impulse
  *
- * @param      impulse  struct with information about model and DSP
- * @param      signal   Sample data
- * @param      result   Output classifier results
- * @param      handle   Handle from open_impulse. nullptr for backward compatibility
- * @param[in]  debug    Debug output enable
+ * @param      handle      Handle from open_impulse
+ * @param      signal      Sample data
+ * @param      signal_i16  Same samples as int16 counts, or nullptr. Used by the DSP
+ *                         blocks that run in fixed point (EIDSP_USE_Q15_SPECTRAL, EIDSP_USE_Q15_MFE)
+ * @param      result      Output classifier results
+ * @param[in]  debug       Debug output enable
  *
  * @return     The ei impulse error.
  */
-extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
-                                            signal_t *signal,
-                                            ei_impulse_result_t *result,
-                                            bool debug = false)
+static EI_IMPULSE_ERROR process_impulse_internal(ei_impulse_handle_t *handle,
+                                                 signal_t *signal,
+                                                 signal_i16_t *signal_i16,
+                                                 ei_impulse_result_t *result,
+                                                 bool debug)
 {
+    (void)signal_i16;
+
     if ((handle == nullptr) || (handle->impulse  == nullptr) || (result  == nullptr) || (signal  == nullptr)) {
         return EI_IMPULSE_INFERENCE_ERROR;
     }
 
     memset(result, 0, sizeof(ei_impulse_result_t));
 
-#if EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
-    static std::vector<ei_impulse_result_classification_t> classification_results;
-    classification_results.clear(); // todo, should not clear and re-gen this every time...
+    // everything allocated for this inference comes from (and stays valid in) the arena
+    ei::InferenceArenaScope arena_scope;
 
+#if EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
     if (handle->impulse->results_type == EI_CLASSIFIER_TYPE_CLASSIFICATION ||
         handle->impulse->results_type == EI_CLASSIFIER_TYPE_REGRESSION) {
     #ifdef EI_DSP_RESULT_OVERRIDE
-        for (size_t ix = 0; ix < EI_DSP_RESULT_OVERRIDE; ix++) {
-            ei_impulse_result_classification_t classification = {
-                .label = "",
-                .value = 0.0f
-            };
-            classification_results.push_back(classification);
-        }
+        size_t classification_count = EI_DSP_RESULT_OVERRIDE;
     #else
-        for (size_t ix = 0; ix < handle->impulse->label_count; ix++) {
-            ei_impulse_result_classification_t classification = {
-                .label = handle->impulse->categories[ix],
-                .value = 0.0f
-            };
-            classification_results.push_back(classification);
+        size_t classification_count = handle->impulse->label_count;
+    #endif // EI_DSP_RESULT_OVERRIDE
+        result->classification = (ei_impulse_result_classification_t*)ei_inference_arena_calloc(
+            classification_count, sizeof(ei_impulse_result_classification_t));
+        if (result->classification == nullptr) {
+            ei_printf("ERR: Out of memory, can't allocate classification results (increase EI_CLASSIFIER_INFERENCE_ARENA_SIZE)\n");
+            return EI_IMPULSE_ALLOC_FAILED;
         }
+        for (size_t ix = 0; ix < classification_count; ix++) {
+    #ifdef EI_DSP_RESULT_OVERRIDE
+            result->classification[ix].label = "";
+    #else
+            result->classification[ix].label = handle->impulse->categories[ix];
     #endif // EI_DSP_RESULT_OVERRIDE
+        }
     }
-
-    result->classification = classification_results.data();
 #endif // EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
 
     uint8_t num_results = handle->impulse->output_tensors_size;
 
-    std::unique_ptr<ei_feature_t[]> raw_results_ptr(new ei_feature_t[num_results]);
-
-    result->_raw_outputs = raw_results_ptr.get();
-    memset(result->_raw_outputs, 0, sizeof(ei_feature_t) * num_results);
+    result->_raw_outputs = (ei_feature_t*)ei_inference_arena_calloc(num_results, sizeof(ei_feature_t));
+    if (result->_raw_outputs == nullptr) {
+        ei_printf("ERR: Out of memory, can't allocate raw outputs (increase EI_CLASSIFIER_INFERENCE_ARENA_SIZE)\n");
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
 
     EI_IMPULSE_ERROR res = EI_IMPULSE_OK;
     (void)res; // Get around -Werror=unused-variable if neither of the calls below are compiled in (e.g. unit-tests/hr)
@@ -280,24 +331,12 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
 #endif // EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ONNX_TIDL) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ATON
     uint32_t block_num = handle->impulse->dsp_blocks_size;
 
-    // smart pointer to features array
-    std::unique_ptr<ei_feature_t[]> features_ptr(new ei_feature_t[block_num]);
-    ei_feature_t* features = features_ptr.get();
+    ei_feature_t* features = (ei_feature_t*)ei_inference_arena_calloc(block_num, sizeof(ei_feature_t));
+    // matrix headers of all blocks, the buffers are allocated per block below
+    ei::matrix_t* matrices = (ei::matrix_t*)ei_inference_arena_calloc(block_num, sizeof(ei::matrix_t));
 
-    if (features == nullptr) {
-        ei_printf("ERR: Out of memory, can't allocate features\n");
-        return EI_IMPULSE_ALLOC_FAILED;
-    }
-
-    memset(features, 0, sizeof(ei_feature_t) * block_num);
-
-    // have it outside of the loop to avoid going out of scope
-    std::unique_ptr<std::unique_ptr<ei::matrix_t>[]> matrix_ptrs_ptr(new std::unique_ptr<ei::matrix_t>[block_num]);
-    std::unique_ptr<ei::matrix_t> *matrix_ptrs = matrix_ptrs_ptr.get();
-
-    if (matrix_ptrs == nullptr) {
-        delete[] matrix_ptrs;
-        ei_printf("ERR: Out of memory, can't allocate matrix_ptrs\n");
+    if (features == nullptr || matrices == nullptr) {
+        ei_printf("ERR: Out of memory, can't allocate features (increase EI_CLASSIFIER_INFERENCE_ARENA_SIZE)\n");
         return EI_IMPULSE_ALLOC_FAILED;
     }
 
@@ -308,19 +347,14 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
     for (size_t ix = 0; ix < handle->impulse->dsp_blocks_size; ix++) {
         ei_model_dsp_t block = handle->impulse->dsp_blocks[ix];
 
-        matrix_ptrs[ix] = std::unique_ptr<ei::matrix_t>(new ei::matrix_t(1, block.n_output_features));
-        if (matrix_ptrs[ix] == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-            return EI_IMPULSE_ALLOC_FAILED;
-        }
-
-        if (matrix_ptrs[ix]->buffer == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-            delete[] matrix_ptrs;
+        float *matrix_buffer = (float*)ei_inference_arena_calloc(block.n_output_features, sizeof(float));
+        if (matrix_buffer == nullptr) {
+            ei_printf("ERR: Out of memory, can't allocate features[%lu] (increase EI_CLASSIFIER_INFERENCE_ARENA_SIZE)\n", (unsigned long)ix);
             return EI_IMPULSE_ALLOC_FAILED;
         }
 
-        features[ix].matrix = matrix_ptrs[ix].get();
+        // the arena owns the buffer, the matrix never frees it so it needs no destructor call
+        features[ix].matrix = ::new (&matrices[ix]) ei::matrix_t(1, block.n_output_features, matrix_buffer);
         features[ix].blockId = block.blockId;
 
         if (out_features_index + block.n_output_features > handle->impulse->nn_input_frame_size) {
@@ -340,6 +374,12 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
 #endif
 
         int ret;
+#if EI_CLASSIFIER_HAS_Q15_DSP == 1
+        extract_fn_q15_t extract_fn_q15 = signal_i16 ? get_extract_fn_q15(handle->impulse, &block) : nullptr;
+        if (extract_fn_q15) {
+            ret = extract_fn_q15(signal_i16, features[ix].matrix, block.config, handle->impulse->frequency);
+        } else
+#endif // EI_CLASSIFIER_HAS_Q15_DSP == 1
         if (block.factory) { // ie, if we're using state
             // Msg user
             static bool has_printed = false;
@@ -420,12 +460,35 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
         return res;
     }
 
+    if (debug) {
+        print_inference_arena_stats();
+    }
+
     ei_result_struct_timing_us_to_ms(result);
 
     return EI_IMPULSE_OK;
 #endif
 }
 
+/**
+ * @brief      Process a complete impulse
+ *
+ * @param      impulse  struct with information about model and DSP
+ * @param      signal   Sample data
+ * @param      result   Output classifier results
+ * @param      handle   Handle from open_impulse. nullptr for backward compatibility
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
+                                            signal_t *signal,
+                                            ei_impulse_result_t *result,
+                                            bool debug = false)
+{
+    return process_impulse_internal(handle, signal, nullptr, result, debug);
+}
+
 /**
  * @brief      Opens an impulse
  *
@@ -441,6 +504,96 @@ extern "C" EI_IMPULSE_ERROR init_impulse(ei_impulse_handle_t *handle) {
     return EI_IMPULSE_OK;
 }
 
+/**
+ * @brief      Builds the FFT plans of the DSP blocks up front (see ei::fft_plan_cache),
+ *             so the first inference doesn't pay for them
+ *
+ * @param      impulse  struct with information about model and DSP
+ */
+static void init_fft_plans(const ei_impulse_t *impulse)
+{
+    for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
+        const ei_model_dsp_t &block = impulse->dsp_blocks[ix];
+        int fft_length = 0;
+
+        if (block.extract_fn == extract_spectral_analysis_features) {
+            auto config = (ei_dsp_config_spectral_analysis_t *)block.config;
+            if (strcmp(config->analysis_type, "FFT") == 0) {
+                fft_length = config->fft_length;
+            }
+        }
+        else if (block.extract_fn == extract_mfcc_features) {
+            fft_length = ((ei_dsp_config_mfcc_t *)block.config)->fft_length;
+        }
+        else if (block.extract_fn == extract_mfe_features) {
+            fft_length = ((ei_dsp_config_mfe_t *)block.config)->fft_length;
+        }
+        else if (block.extract_fn == extract_spectrogram_features) {
+            fft_length = ((ei_dsp_config_spectrogram_t *)block.config)->fft_length;
+        }
+
+        if (fft_length > 0) {
+            // not fatal, the plan is built on first use instead
+            int ret = numpy::rfft_init(fft_length);
+            if (ret != EIDSP_OK) {
+                ei_printf("WARN: Failed to prepare FFT of length %d (%d)\n", fft_length, ret);
+            }
+        }
+    }
+}
+
+/**
+ * @brief      Builds the sparse mel filterbanks of the MFE / MFCC blocks up front
+ *             (see ei::speechpy::mel_filterbank_cache), so the first inference doesn't pay for them.
+ *             Compiled out without EIDSP_MEL_FILTERBANK_CACHE_SIZE, so the cache isn't linked in
+ *
+ * @param      impulse  struct with information about model and DSP
+ */
+static void init_mel_filterbanks(const ei_impulse_t *impulse)
+{
+#if EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+    for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
+        const ei_model_dsp_t &block = impulse->dsp_blocks[ix];
+        speechpy::mel_filterbank_t config = { 0 };
+
+        // same dispatch as extract_mfcc_features / extract_mfe_features
+        if (block.extract_fn == extract_mfcc_features) {
+            auto mfcc_config = (ei_dsp_config_mfcc_t *)block.config;
+            config.type = speechpy::MEL_FILTERBANK_TRIANGLE;
+            config.version = mfcc_config->implementation_version;
+            config.num_filters = mfcc_config->num_filters;
+            config.fft_length = mfcc_config->fft_length;
+            config.low_frequency = mfcc_config->low_frequency;
+            config.high_frequency = mfcc_config->high_frequency;
+        }
+        else if (block.extract_fn == extract_mfe_features) {
+            auto mfe_config = (ei_dsp_config_mfe_t *)block.config;
+            config.type = mfe_config->implementation_version > 2 ?
+                speechpy::MEL_FILTERBANK_TRIANGLE : speechpy::MEL_FILTERBANK_SPEECHPY;
+            config.version = mfe_config->implementation_version;
+            config.num_filters = mfe_config->num_filters;
+            config.fft_length = mfe_config->fft_length;
+            config.low_frequency = mfe_config->low_frequency;
+            config.high_frequency = mfe_config->high_frequency;
+        }
+        else {
+            continue;
+        }
+
+        config.sampling_frequency = static_cast<uint32_t>(impulse->frequency);
+        speechpy::mel_filterbank::resolve_config(&config);
+
+        // not fatal, the filterbank is then built on every call
+        if (!speechpy::mel_filterbank_cache::get(&config)) {
+            ei_printf("WARN: Mel filterbank of block %d doesn't fit in EIDSP_MEL_FILTERBANK_CACHE_SIZE\n",
+                (int)block.blockId);
+        }
+    }
+#else
+    (void)impulse;
+#endif // EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+}
+
 /**
  * @brief      Process a complete impulse for continuous inference
  *
@@ -462,33 +615,31 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
 
     memset(result, 0, sizeof(ei_impulse_result_t));
 
-#if EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
-    static std::vector<ei_impulse_result_classification_t> classification_results;
-    classification_results.clear(); // todo, should not clear and re-gen this every time...
+    ei::InferenceArenaScope arena_scope;
 
+#if EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
     if (handle->impulse->results_type == EI_CLASSIFIER_TYPE_CLASSIFICATION ||
         handle->impulse->results_type == EI_CLASSIFIER_TYPE_REGRESSION) {
     #ifdef EI_DSP_RESULT_OVERRIDE
-        for (size_t ix = 0; ix < EI_DSP_RESULT_OVERRIDE; ix++) {
-            ei_impulse_result_classification_t classification = {
-                .label = "",
-                .value = 0.0f
-            };
-            classification_results.push_back(classification);
-        }
+        size_t classification_count = EI_DSP_RESULT_OVERRIDE;
     #else
-        for (size_t ix = 0; ix < handle->impulse->label_count; ix++) {
-            ei_impulse_result_classification_t classification = {
-                .label = handle->impulse->categories[ix],
-                .value = 0.0f
-            };
-            classification_results.push_back(classification);
+        size_t classification_count = handle->impulse->label_count;
+    #endif
+        result->classification = (ei_impulse_result_classification_t*)ei_inference_arena_calloc(
+            classification_count, sizeof(ei_impulse_result_classification_t));
+        if (result->classification == nullptr) {
+            ei_printf("ERR: Out of memory, can't allocate classification results (increase EI_CLASSIFIER_INFERENCE_ARENA_SIZE)\n");
+            return EI_IMPULSE_ALLOC_FAILED;
         }
+        for (size_t ix = 0; ix < classification_count; ix++) {
+    #ifdef EI_DSP_RESULT_OVERRIDE
+            result->classification[ix].label = "";
+    #else
+            result->classification[ix].label = handle->impulse->categories[ix];
     #endif
+        }
     }
 
-    result->classification = classification_results.data();
-
 #else // EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 1
 
     for (int i = 0; i < handle->impulse->label_count; i++) {
@@ -498,13 +649,17 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
 
 #endif // EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
 
-    // smart pointer to results array
-    std::unique_ptr<ei_feature_t[]> raw_results_ptr(new ei_feature_t[handle->impulse->learning_blocks_size]);
-    result->_raw_outputs = raw_results_ptr.get();
-    memset(result->_raw_outputs, 0, sizeof(ei_feature_t) * handle->impulse->learning_blocks_size);
+    result->_raw_outputs = (ei_feature_t*)ei_inference_arena_calloc(handle->impulse->learning_blocks_size, sizeof(ei_feature_t));
+    if (result->_raw_outputs == nullptr) {
+        ei_printf("ERR: Out of memory, can't allocate raw outputs (increase EI_CLASSIFIER_INFERENCE_ARENA_SIZE)\n");
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
 
     auto impulse = handle->impulse;
+    // keeps the features of all slices, so it lives on the heap
+    ei_inference_arena_pause(true);
     static ei::matrix_t static_features_matrix(1, impulse->nn_input_frame_size);
+    ei_inference_arena_pause(false);
     if (!static_features_matrix.buffer) {
         return EI_IMPULSE_ALLOC_FAILED;
     }
@@ -538,8 +693,12 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         else if (block.extract_fn == extract_mfe_features) {
             extract_fn_slice = &extract_mfe_per_slice_features;
         }
+        else if (block.extract_fn == extract_spectral_analysis_features) {
+            extract_fn_slice = &extract_spectral_analysis_per_slice_features;
+            ei_dsp_cont_spectral_window_samples = impulse->raw_sample_count;
+        }
         else {
-            ei_printf("ERR: Unknown extract function, only MFCC, MFE and spectrogram supported\n");
+            ei_printf("ERR: Unknown extract function, only MFCC, MFE, spectrogram and spectral analysis supported\n");
             return EI_IMPULSE_DSP_ERROR;
         }
 
@@ -577,19 +736,10 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
 
         uint32_t block_num = impulse->dsp_blocks_size + impulse->learning_blocks_size;
 
-        // smart pointer to features array
-        std::unique_ptr<ei_feature_t[]> features_ptr(new ei_feature_t[block_num]);
-        ei_feature_t* features = features_ptr.get();
-        if (features == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate features\n");
-            return EI_IMPULSE_ALLOC_FAILED;
-        }
-        memset(features, 0, sizeof(ei_feature_t) * block_num);
-
-        // have it outside of the loop to avoid going out of scope
-        std::unique_ptr<ei::matrix_t> *matrix_ptrs = new std::unique_ptr<ei::matrix_t>[block_num];
-        if (matrix_ptrs == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate matrix_ptrs\n");
+        ei_feature_t* features = (ei_feature_t*)ei_inference_arena_calloc(block_num, sizeof(ei_feature_t));
+        ei::matrix_t* matrices = (ei::matrix_t*)ei_inference_arena_calloc(block_num, sizeof(ei::matrix_t));
+        if (features == nullptr || matrices == nullptr) {
+            ei_printf("ERR: Out of memory, can't allocate features (increase EI_CLASSIFIER_INFERENCE_ARENA_SIZE)\n");
             return EI_IMPULSE_ALLOC_FAILED;
         }
 
@@ -597,20 +747,13 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         // iterate over every dsp block and run normalization
         for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
             ei_model_dsp_t block = impulse->dsp_blocks[ix];
-            matrix_ptrs[ix] = std::unique_ptr<ei::matrix_t>(new ei::matrix_t(1, block.n_output_features));
-
-            if (matrix_ptrs[ix] == nullptr) {
-                ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
+            float *matrix_buffer = (float*)ei_inference_arena_calloc(block.n_output_features, sizeof(float));
+            if (matrix_buffer == nullptr) {
+                ei_printf("ERR: Out of memory, can't allocate features[%lu] (increase EI_CLASSIFIER_INFERENCE_ARENA_SIZE)\n", (unsigned long)ix);
                 return EI_IMPULSE_ALLOC_FAILED;
             }
 
-            if (matrix_ptrs[ix]->buffer == nullptr) {
-                ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-                delete[] matrix_ptrs;
-                return EI_IMPULSE_ALLOC_FAILED;
-            }
-
-            features[ix].matrix = matrix_ptrs[ix].get();
+            features[ix].matrix = ::new (&matrices[ix]) ei::matrix_t(1, block.n_output_features, matrix_buffer);
             features[ix].blockId = block.blockId;
 
             /* Create a copy of the matrix for normalization */
@@ -646,11 +789,14 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         if (ei_impulse_error != EI_IMPULSE_OK) {
             return ei_impulse_error;
         }
-        delete[] matrix_ptrs;
         ei_impulse_error = run_postprocessing(handle, result);
         if (ei_impulse_error != EI_IMPULSE_OK) {
             return ei_impulse_error;
         }
+
+        if (debug) {
+            print_inference_arena_stats();
+        }
     }
 
     ei_result_struct_timing_us_to_ms(result);
@@ -865,7 +1011,10 @@ extern "C" void run_classifier_init(void)
 
     classifier_continuous_features_written = 0;
     ei_dsp_clear_continuous_audio_state();
+    ei_inference_arena_reset();
     init_impulse(&ei_default_impulse);
+    init_fft_plans(ei_default_impulse.impulse);
+    init_mel_filterbanks(ei_default_impulse.impulse);
     init_postprocessing(&ei_default_impulse);
 #if EI_CLASSIFIER_HAS_DATA_NORMALIZATION
     init_data_normalization(&ei_default_impulse);
@@ -890,7 +1039,10 @@ __attribute__((unused)) void run_classifier_init(ei_impulse_handle_t *handle)
 {
     classifier_continuous_features_written = 0;
     ei_dsp_clear_continuous_audio_state();
+    ei_inference_arena_reset();
     init_impulse(handle);
+    init_fft_plans(handle->impulse);
+    init_mel_filterbanks(handle->impulse);
     init_postprocessing(handle);
 #if EI_CLASSIFIER_HAS_DATA_NORMALIZATION
     init_data_normalization(handle);
@@ -911,14 +1063,20 @@ __attribute__((unused)) void run_classifier_init(ei_impulse_handle_t *handle)
 extern "C" void run_classifier_deinit(void)
 {
     deinit_postprocessing(&ei_default_impulse);
+    ei::fft_plan_cache::clear();
+    ei::speechpy::mel_filterbank_cache::clear();
+    ei_inference_arena_reset();
 }
 
 __attribute__((unused)) void run_classifier_deinit(ei_impulse_handle_t *handle)
 {
     deinit_postprocessing(handle);
+    ei::fft_plan_cache::clear();
+    ei::speechpy::mel_filterbank_cache::clear();
 #if EI_CLASSIFIER_HAS_DATA_NORMALIZATION
     deinit_data_normalization(handle);
 #endif
+    ei_inference_arena_reset();
 }
 
 /**
@@ -1100,6 +1258,75 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_classifier(
     return process_impulse(impulse, signal, result, debug);
 }
 
+#if EIDSP_SIGNAL_C_FN_POINTER == 0
+/**
+ * @brief Run the classifier over raw int16 sensor counts.
+ *
+ * With EIDSP_USE_Q15_SPECTRAL (CMSIS-DSP only) spectral analysis blocks, with
+ * EIDSP_USE_Q15_MFE MFE blocks run in fixed point straight on the counts. All other blocks,
+ * and configs the fixed point implementations do not cover, read the counts converted to float.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in] impulse Pointer to an `ei_impulse_handle_t` struct that contains the model and
+ *  preprocessing information.
+ * @param[in] signal Pointer to a `signal_i16_t` struct, laid out like `signal_t`. `scale`
+ *  converts counts to the units the impulse was trained on (e.g. m/s2 per LSB).
+ * @param[out] result  Pointer to an ei_impulse_result_t struct that will contain the various output
+ *  results from inference after `run_classifier_i16()` returns.
+ * @param[in] debug Print internal preprocessing and inference debugging information via `ei_printf()`.
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum. Will be `EI_IMPULSE_OK` if inference
+ *  completed successfully.
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_i16(
+    ei_impulse_handle_t *impulse,
+    signal_i16_t *signal,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    if (signal == nullptr) {
+        return EI_IMPULSE_INFERENCE_ERROR;
+    }
+
+    signal_t float_signal;
+    float_signal.total_length = signal->total_length;
+    float_signal.get_data = [signal](size_t offset, size_t length, float *out_ptr) {
+        int16_t chunk[64];
+
+        while (length > 0) {
+            size_t n = length < 64 ? length : 64;
+            int r = signal->get_data(offset, n, chunk);
+            if (r != 0) {
+                return r;
+            }
+            for (size_t ix = 0; ix < n; ix++) {
+                out_ptr[ix] = chunk[ix] * signal->scale;
+            }
+            offset += n;
+            out_ptr += n;
+            length -= n;
+        }
+        return 0;
+    };
+
+    return process_impulse_internal(impulse, &float_signal, signal, result, debug);
+}
+
+/**
+ * @brief Run the classifier over raw int16 sensor counts.
+ *
+ * Overloaded function [run_classifier_i16()](#run_classifier_i16-1) that defaults to the single impulse.
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_i16(
+    signal_i16_t *signal,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    return run_classifier_i16(&ei_default_impulse, signal, result, debug);
+}
+#endif // EIDSP_SIGNAL_C_FN_POINTER == 0
+
 #if EI_CLASSIFIER_FREEFORM_OUTPUT
 /**
  * Set the location for freeform outputs. For impulses with freeform output the application needs to allocate
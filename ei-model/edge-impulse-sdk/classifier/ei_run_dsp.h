@@ -36,6 +36,7 @@
 #define _EDGE_IMPULSE_RUN_DSP_H_
 
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_inference_arena.h"
 #include "edge-impulse-sdk/dsp/spectral/spectral.hpp"
 #include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
 #include "edge-impulse-sdk/classifier/ei_signal_with_range.h"
@@ -89,6 +90,24 @@ static float *ei_dsp_cont_current_frame = nullptr;
 static size_t ei_dsp_cont_current_frame_size = 0;
 static int ei_dsp_cont_current_frame_ix = 0;
 
+// window length (in samples) for the per-slice spectral analysis, set by the continuous classifier
+static size_t ei_dsp_cont_spectral_window_samples = 0;
+
+// per-slice spectral analysis state of one DSP block, keyed by the block config
+typedef struct ei_dsp_cont_spectral_state {
+    struct ei_dsp_cont_spectral_state *next;
+    const void *config;
+    // sliding window
+    float *window;
+    size_t window_size;
+    size_t window_filled;
+    // samples seen by the sliding window, and the Welch segment spectra of earlier windows
+    uint64_t stream_ix;
+    spectral::welch_segment_cache_t segments;
+} ei_dsp_cont_spectral_state_t;
+
+static ei_dsp_cont_spectral_state_t *ei_dsp_cont_spectral_states = nullptr;
+
 __attribute__((unused)) int extract_hr_features(
     signal_t *signal,
     matrix_t *output_matrix,
@@ -188,6 +207,251 @@ __attribute__((unused)) int extract_spectral_analysis_features(
     return EIDSP_NOT_SUPPORTED;
 }
 
+#if EIDSP_USE_Q15_SPECTRAL == 1 && EIDSP_USE_CMSIS_DSP == 1
+/**
+ * @brief Spectral analysis in fixed point, straight from int16 sensor counts.
+ * Only for configs where spectral::feature_q15::is_supported() holds, the output matches
+ * extract_spectral_analysis_features().
+ */
+__attribute__((unused)) int extract_spectral_analysis_features_q15(
+    signal_i16_t *signal,
+    matrix_t *output_matrix,
+    void *config_ptr,
+    const float frequency)
+{
+    ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t *)config_ptr;
+
+    return spectral::feature_q15::extract_spec_features(signal, output_matrix, config, frequency);
+}
+#endif // EIDSP_USE_Q15_SPECTRAL == 1 && EIDSP_USE_CMSIS_DSP == 1
+
+#if EIDSP_USE_Q15_MFE == 1 && EIDSP_USE_CMSIS_DSP == 1
+/**
+ * @brief MFE in fixed point, straight from int16 audio samples.
+ * Only for configs where speechpy::feature_q15::is_supported() holds, the output has the
+ * layout of extract_mfe_features().
+ */
+__attribute__((unused)) int extract_mfe_features_q15(
+    signal_i16_t *signal,
+    matrix_t *output_matrix,
+    void *config_ptr,
+    const float frequency)
+{
+    ei_dsp_config_mfe_t *config = (ei_dsp_config_mfe_t *)config_ptr;
+
+    int ret = speechpy::feature_q15::extract_mfe_features(signal, output_matrix, config, frequency);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: MFE failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    output_matrix->cols = output_matrix->rows * output_matrix->cols;
+    output_matrix->rows = 1;
+
+    return EIDSP_OK;
+}
+#endif // EIDSP_USE_Q15_MFE == 1 && EIDSP_USE_CMSIS_DSP == 1
+
+static void ei_dsp_free_spectral_segments(ei_dsp_cont_spectral_state_t *state)
+{
+    if (state->segments.spectra) {
+        ei_free(state->segments.spectra);
+    }
+    if (state->segments.keys) {
+        ei_free(state->segments.keys);
+    }
+    memset(&state->segments, 0, sizeof(state->segments));
+}
+
+static void ei_dsp_free_spectral_states()
+{
+    while (ei_dsp_cont_spectral_states) {
+        ei_dsp_cont_spectral_state_t *state = ei_dsp_cont_spectral_states;
+        ei_dsp_cont_spectral_states = state->next;
+
+        if (state->window) {
+            ei_free(state->window);
+        }
+        ei_dsp_free_spectral_segments(state);
+        ei_free(state);
+    }
+}
+
+/**
+ * Sliding window state of the block with this config, created on first use
+ * @returns nullptr on OOM
+ */
+static ei_dsp_cont_spectral_state_t *ei_dsp_get_spectral_state(const void *config_ptr)
+{
+    for (ei_dsp_cont_spectral_state_t *state = ei_dsp_cont_spectral_states; state; state = state->next) {
+        if (state->config == config_ptr) {
+            return state;
+        }
+    }
+
+    // kept across calls, so not from the inference arena
+    ei_inference_arena_pause(true);
+    ei_dsp_cont_spectral_state_t *state = (ei_dsp_cont_spectral_state_t*)ei_calloc(sizeof(ei_dsp_cont_spectral_state_t), 1);
+    ei_inference_arena_pause(false);
+    if (!state) {
+        return nullptr;
+    }
+    state->config = config_ptr;
+    state->next = ei_dsp_cont_spectral_states;
+    ei_dsp_cont_spectral_states = state;
+
+    return state;
+}
+
+/**
+ * Segment spectra cache for the sliding window, (re)allocated when the config changes
+ * @returns nullptr if the config can't reuse segments, or on OOM
+ */
+static spectral::welch_segment_cache_t *ei_dsp_get_spectral_segments(ei_dsp_cont_spectral_state_t *state, ei_dsp_config_spectral_analysis_t *config)
+{
+    if (!spectral::feature::can_cache_welch_segments(config)) {
+        return nullptr;
+    }
+
+    const size_t slots = spectral::feature::get_welch_segment_count(
+        ei_dsp_cont_spectral_window_samples, config->fft_length, config->do_fft_overlap);
+    const size_t bins = config->fft_length / 2 + 1;
+    if (slots == 0) {
+        return nullptr;
+    }
+
+    spectral::welch_segment_cache_t *cache = &state->segments;
+    if (cache->axes != (size_t)config->axes || cache->slots != slots || cache->bins != bins) {
+        ei_dsp_free_spectral_segments(state);
+
+        // kept across calls, so not from the inference arena
+        ei_inference_arena_pause(true);
+        cache->spectra = (float*)ei_calloc(config->axes * slots * bins * sizeof(float), 1);
+        cache->keys = (uint64_t*)ei_calloc(config->axes * slots * sizeof(uint64_t), 1);
+        ei_inference_arena_pause(false);
+        if (!cache->spectra || !cache->keys) {
+            // not fatal, every segment is calculated instead
+            ei_dsp_free_spectral_segments(state);
+            return nullptr;
+        }
+        cache->axes = config->axes;
+        cache->slots = slots;
+        cache->bins = bins;
+    }
+
+    return cache;
+}
+
+/**
+ * @brief Spectral analysis for continuous classification. The features describe the whole
+ * window, so the slices are collected in a sliding window (kept between calls) and the
+ * features are calculated over it on every slice, i.e. at the slice rate.
+ * Every spectral analysis block has its own window, keyed by config_ptr.
+ * Until the window is complete, no features are written (matrix_size_out is 0x0).
+ * A signal of at least a full window is processed directly.
+ */
+__attribute__((unused)) int extract_spectral_analysis_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency, matrix_size_t *matrix_size_out) {
+    ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t *)config_ptr;
+    const size_t window_size = ei_dsp_cont_spectral_window_samples * config->axes;
+
+    matrix_size_out->rows = 0;
+    matrix_size_out->cols = 0;
+
+    if (window_size == 0 || signal->total_length == 0) {
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    if (signal->total_length % config->axes != 0) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    ei_dsp_cont_spectral_state_t *state = ei_dsp_get_spectral_state(config_ptr);
+    if (!state) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+
+    // have window, but wrong size? then free
+    if (state->window && state->window_size != window_size) {
+        ei_free(state->window);
+        state->window = nullptr;
+    }
+
+    if (!state->window) {
+        // kept across calls, so not from the inference arena
+        ei_inference_arena_pause(true);
+        state->window = (float*)ei_calloc(window_size * sizeof(float), 1);
+        ei_inference_arena_pause(false);
+        if (!state->window) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        state->window_size = window_size;
+        state->window_filled = 0;
+    }
+
+    state->stream_ix += signal->total_length / config->axes;
+
+    int ret;
+    if (signal->total_length >= window_size) {
+        // keep the newest window
+        ret = signal->get_data(signal->total_length - window_size, window_size, state->window);
+        state->window_filled = window_size;
+    }
+    else {
+        const size_t keep = window_size - signal->total_length;
+        memmove(state->window,
+                state->window + signal->total_length,
+                keep * sizeof(float));
+        ret = signal->get_data(0, signal->total_length, state->window + keep);
+        state->window_filled += signal->total_length;
+        if (state->window_filled > window_size) {
+            state->window_filled = window_size;
+        }
+    }
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    if (state->window_filled < window_size) {
+        return EIDSP_OK;
+    }
+
+    spectral::welch_segment_cache_t *segments = ei_dsp_get_spectral_segments(state, config);
+    if (segments) {
+        // only the Welch segments that weren't in an earlier window go through the FFT
+        segments->window_start = state->stream_ix - ei_dsp_cont_spectral_window_samples;
+
+        matrix_t input_matrix(ei_dsp_cont_spectral_window_samples, config->axes);
+        if (!input_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        memcpy(input_matrix.buffer, state->window, window_size * sizeof(float));
+
+        ret = spectral::feature::extract_spectral_analysis_features_v2(
+            &input_matrix,
+            output_matrix,
+            config,
+            frequency,
+            segments);
+    }
+    else {
+        signal_t window_signal;
+        ret = numpy::signal_from_buffer(state->window, window_size, &window_signal);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        ret = extract_spectral_analysis_features(&window_signal, output_matrix, config_ptr, frequency);
+    }
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    matrix_size_out->rows = output_matrix->rows;
+    matrix_size_out->cols = output_matrix->cols;
+
+    return EIDSP_OK;
+}
+
 __attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
     ei_dsp_config_raw_t config = *((ei_dsp_config_raw_t*)config_ptr);
 
@@ -385,7 +649,10 @@ __attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, ma
     size_t offset_in_signal = 0;
 
     if (!ei_dsp_cont_current_frame) {
+        // kept across calls, so not from the inference arena
+        ei_inference_arena_pause(true);
         ei_dsp_cont_current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
+        ei_inference_arena_pause(false);
         if (!ei_dsp_cont_current_frame) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
@@ -659,7 +926,10 @@ __attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *sig
     }
 
     if (!ei_dsp_cont_current_frame) {
+        // kept across calls, so not from the inference arena
+        ei_inference_arena_pause(true);
         ei_dsp_cont_current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
+        ei_inference_arena_pause(false);
         if (!ei_dsp_cont_current_frame) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
@@ -1007,7 +1277,10 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
     }
 
     if (!ei_dsp_cont_current_frame) {
+        // kept across calls, so not from the inference arena
+        ei_inference_arena_pause(true);
         ei_dsp_cont_current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
+        ei_inference_arena_pause(false);
         if (!ei_dsp_cont_current_frame) {
             if (preemphasis) {
                 delete preemphasis;
@@ -1412,6 +1685,8 @@ __attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
     ei_dsp_cont_current_frame_size = 0;
     ei_dsp_cont_current_frame_ix = 0;
 
+    ei_dsp_free_spectral_states();
+
     return EIDSP_OK;
 }
 
@@ -35,6 +35,8 @@
 #ifndef _EI_CLASSIFIER_SIGNAL_WITH_AXES_H_
 #define _EI_CLASSIFIER_SIGNAL_WITH_AXES_H_
 
+#include <string.h>
+#include <algorithm>
 #include "edge-impulse-sdk/dsp/numpy_types.h"
 #include "edge-impulse-sdk/dsp/returntypes.hpp"
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
@@ -48,7 +50,18 @@ public:
     SignalWithAxes(signal_t *original_signal, EI_CLASSIFIER_DSP_AXES_INDEX_TYPE *axes, size_t axes_count, const ei_impulse_t *impulse):
         _original_signal(original_signal), _axes(axes), _axes_count(axes_count), _impulse(impulse)
     {
-
+        // span of the selected axes within a frame, and whether they're a contiguous run
+        size_t axes_last = 0;
+        _axes_first = axes_count > 0 ? axes[0] : 0;
+        _axes_contiguous = true;
+        for (size_t axis_ix = 0; axis_ix < axes_count; axis_ix++) {
+            _axes_first = std::min(_axes_first, (size_t)axes[axis_ix]);
+            axes_last = std::max(axes_last, (size_t)axes[axis_ix]);
+            if ((size_t)axes[axis_ix] != (size_t)axes[0] + axis_ix) {
+                _axes_contiguous = false;
+            }
+        }
+        _axes_span = axes_last - _axes_first + 1;
     }
 
     signal_t * get_signal() {
@@ -67,29 +80,85 @@ public:
         return &wrapped_signal;
     }
 
+    /**
+     * Reads whole frames of the original signal in chunks and deinterleaves the selected
+     * axes, rather than reading them one value at a time.
+     */
     int get_data(size_t offset, size_t length, float *out_ptr) {
-        size_t offset_on_original_signal = offset / _axes_count * _impulse->raw_samples_per_frame;
-        size_t length_on_original_signal = length / _axes_count * _impulse->raw_samples_per_frame;
+        const size_t frame_size = _impulse->raw_samples_per_frame;
+        float chunk[SIGNAL_WITH_AXES_CHUNK_SIZE];
+
+        // a frame doesn't fit in the chunk, read the values one by one
+        if (_axes_span > SIGNAL_WITH_AXES_CHUNK_SIZE) {
+            return get_data_per_value(offset, length, out_ptr);
+        }
+
+        size_t frame_ix = offset / _axes_count;
+        size_t axis_ix = offset % _axes_count;
+
+        while (length > 0) {
+            // frames (partially) covered by the rest of the request, limited by the chunk
+            size_t frames = (axis_ix + length + _axes_count - 1) / _axes_count;
+            size_t max_frames = 1 + (SIGNAL_WITH_AXES_CHUNK_SIZE - _axes_span) / frame_size;
+            if (frames > max_frames) {
+                frames = max_frames;
+            }
+
+            // from the first selected axis of the first frame to the last one of the last frame
+            int r = _original_signal->get_data(frame_ix * frame_size + _axes_first,
+                (frames - 1) * frame_size + _axes_span, chunk);
+            if (r != 0) {
+                return r;
+            }
 
-        size_t out_ptr_ix = 0;
+            for (size_t f = 0; f < frames && length > 0; f++) {
+                // the chunk starts at the first selected axis
+                const float *frame = &chunk[f * frame_size];
+                size_t n = std::min(_axes_count - axis_ix, length);
 
-        for (size_t ix = offset_on_original_signal; ix < offset_on_original_signal + length_on_original_signal; ix += _impulse->raw_samples_per_frame) {
-            for (size_t axis_ix = 0; axis_ix < this->_axes_count; axis_ix++) {
-                int r = _original_signal->get_data(ix + _axes[axis_ix], 1, &out_ptr[out_ptr_ix++]);
-                if (r != 0) {
-                    return r;
+                if (_axes_contiguous) {
+                    memcpy(out_ptr, frame + (_axes[axis_ix] - _axes_first), n * sizeof(float));
                 }
+                else {
+                    for (size_t ix = 0; ix < n; ix++) {
+                        out_ptr[ix] = frame[_axes[axis_ix + ix] - _axes_first];
+                    }
+                }
+
+                out_ptr += n;
+                length -= n;
+                axis_ix = 0;
             }
+            frame_ix += frames;
         }
 
         return 0;
     }
 
 private:
+    // floats on the stack per read of the original signal
+    static const size_t SIGNAL_WITH_AXES_CHUNK_SIZE = 64;
+
+    int get_data_per_value(size_t offset, size_t length, float *out_ptr) {
+        for (size_t ix = 0; ix < length; ix++) {
+            size_t frame_ix = (offset + ix) / _axes_count;
+            size_t axis_ix = (offset + ix) % _axes_count;
+            int r = _original_signal->get_data(frame_ix * _impulse->raw_samples_per_frame + _axes[axis_ix], 1, &out_ptr[ix]);
+            if (r != 0) {
+                return r;
+            }
+        }
+
+        return 0;
+    }
+
     signal_t *_original_signal;
     EI_CLASSIFIER_DSP_AXES_INDEX_TYPE *_axes;
     size_t _axes_count;
     const ei_impulse_t *_impulse;
+    size_t _axes_first;
+    size_t _axes_span;
+    bool _axes_contiguous;
     signal_t wrapped_signal;
 };
 
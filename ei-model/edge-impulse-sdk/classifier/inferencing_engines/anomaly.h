@@ -47,6 +47,10 @@
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/engines.h"
+#include "edge-impulse-sdk/dsp/config.hpp"
+#if EIDSP_USE_CMSIS_DSP
+#include "edge-impulse-sdk/CMSIS/DSP/Include/arm_math.h"
+#endif
 
 #ifdef __cplusplus
 namespace {
@@ -67,24 +71,58 @@ static void standard_scaler(float *input, const float *scale, const float *mean,
     }
 }
 
+// number of axes summed with CMSIS-DSP between two early termination checks
+#define EI_ANOMALY_KMEANS_CHUNK_SIZE    16
+
 /**
- * Calculate the distance between input vector and the cluster
+ * Calculate the squared distance between input vector and a cluster centroid.
+ * Stops early once the partial sum reaches bound, as the cluster can't be the closest one.
  * @param input Array of input values (already scaled by standard_scaler)
  * @param input_size Size of the input array
- * @param cluster A cluster (number of centroids should match input_size)
+ * @param centroid Cluster centroid (size should match input_size)
+ * @param bound Squared distance at which to stop summing
+ * @returns Squared distance, or a partial sum >= bound
  */
-static float calculate_cluster_distance(float *input, size_t input_size, const ei_classifier_anom_cluster_t *cluster) {
-    // todo: check input_size and centroid size?
-
+static float calculate_cluster_distance_squared(const float *input, size_t input_size, const float *centroid, float bound) {
     float dist = 0.0f;
-    for (size_t ix = 0; ix < input_size; ix++) {
-        dist += pow(input[ix] - cluster->centroid[ix], 2);
+    size_t ix = 0;
+
+#if EIDSP_USE_CMSIS_DSP
+    float diff[EI_ANOMALY_KMEANS_CHUNK_SIZE];
+    for (; ix + EI_ANOMALY_KMEANS_CHUNK_SIZE <= input_size; ix += EI_ANOMALY_KMEANS_CHUNK_SIZE) {
+        float chunk_dist;
+        arm_sub_f32(input + ix, centroid + ix, diff, EI_ANOMALY_KMEANS_CHUNK_SIZE);
+        arm_power_f32(diff, EI_ANOMALY_KMEANS_CHUNK_SIZE, &chunk_dist);
+        dist += chunk_dist;
+        if (dist >= bound) {
+            return dist;
+        }
     }
-    return sqrt(dist) - cluster->max_error;
+#endif
+
+    // check the bound every 4 axes, a compare per axis costs more than it prunes
+    for (; ix + 4 <= input_size; ix += 4) {
+        const float d0 = input[ix] - centroid[ix];
+        const float d1 = input[ix + 1] - centroid[ix + 1];
+        const float d2 = input[ix + 2] - centroid[ix + 2];
+        const float d3 = input[ix + 3] - centroid[ix + 3];
+        dist += (d0 * d0 + d1 * d1) + (d2 * d2 + d3 * d3);
+        if (dist >= bound) {
+            return dist;
+        }
+    }
+    for (; ix < input_size; ix++) {
+        const float d = input[ix] - centroid[ix];
+        dist += d * d;
+    }
+    return dist;
 }
 
 /**
  * Get minimum distance to a cluster
+ * The score of a cluster is sqrt(dist) - max_error, so it can only beat the current
+ * minimum if dist < (min + max_error)^2. Comparing squared distances against that bound
+ * prunes most clusters after a few axes, and sqrt is only taken for a new minimum.
  * @param input Array of input values (already scaled by standard_scaler)
  * @param input_size Size of the input array
  * @param clusters Array of clusters
@@ -93,9 +131,18 @@ static float calculate_cluster_distance(float *input, size_t input_size, const e
 static float get_min_distance_to_cluster(float *input, size_t input_size, const ei_classifier_anom_cluster_t *clusters, size_t cluster_size) {
     float min = 1000.0f;
     for (size_t ix = 0; ix < cluster_size; ix++) {
-        float dist = calculate_cluster_distance(input, input_size, &clusters[ix]);
-        if (dist < min) {
-            min = dist;
+        const float reach = min + clusters[ix].max_error;
+        if (reach <= 0.0f) {
+            continue;
+        }
+
+        const float bound = reach * reach;
+        float dist = calculate_cluster_distance_squared(input, input_size, clusters[ix].centroid, bound);
+        if (dist < bound) {
+            dist = sqrtf(dist) - clusters[ix].max_error;
+            if (dist < min) {
+                min = dist;
+            }
         }
     }
     return min;
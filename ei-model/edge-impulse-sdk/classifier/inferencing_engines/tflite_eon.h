@@ -43,6 +43,7 @@
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/tflite_helper.h"
 #include "edge-impulse-sdk/classifier/ei_run_dsp.h"
+#include "edge-impulse-sdk/classifier/ei_op_profile.h"
 
 /**
  * Setup the TFLite runtime
@@ -112,7 +113,20 @@ static EI_IMPULSE_ERROR inference_tflite_run(
 
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
-    if (graph_config->model_invoke() != kTfLiteOk) {
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    ei_op_profile_invoke_begin();
+#endif
+
+    TfLiteStatus invoke_status = graph_config->model_invoke();
+
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    ei_op_profile_invoke_end();
+    if (debug) {
+        ei_op_profile_print();
+    }
+#endif
+
+    if (invoke_status != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
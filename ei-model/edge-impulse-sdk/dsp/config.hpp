@@ -95,6 +95,47 @@
 #define EIDSP_QUANTIZE_FILTERBANK    1
 #endif // EIDSP_QUANTIZE_FILTERBANK
 
+// Run MFE (v3 and up) blocks in fixed point on int16 audio samples, see run_classifier_i16().
+// Pre-emphasis, FFT and filterbank use q15, only log10 and normalization per feature are float.
+// MFCC blocks and run_classifier_continuous() are out of scope and keep using the float path.
+#ifndef EIDSP_USE_Q15_MFE
+#define EIDSP_USE_Q15_MFE            0
+#endif // EIDSP_USE_Q15_MFE
+
+// Run spectral analysis (FFT) blocks in fixed point on raw int16 sensor counts,
+// see run_classifier_i16(). Filter, FFT and statistics use q15 CMSIS-DSP kernels.
+#ifndef EIDSP_USE_Q15_SPECTRAL
+#define EIDSP_USE_Q15_SPECTRAL       0
+#endif // EIDSP_USE_Q15_SPECTRAL
+
+// Static RAM (bytes) for the kissfft plans of FFT sizes without a hardware implementation,
+// see ei_fft_plan_cache.h. Plans that don't fit are built on every call, 0 disables the cache.
+// A plan takes about 280 + 10 * n_fft bytes on 32-bit targets, the default fits one 16 point plan.
+#ifndef EIDSP_FFT_PLAN_CACHE_SIZE
+#define EIDSP_FFT_PLAN_CACHE_SIZE        512
+#endif // EIDSP_FFT_PLAN_CACHE_SIZE
+
+#ifndef EIDSP_FFT_PLAN_CACHE_MAX_PLANS
+#define EIDSP_FFT_PLAN_CACHE_MAX_PLANS   4
+#endif // EIDSP_FFT_PLAN_CACHE_MAX_PLANS
+
+// Static RAM (bytes) for the sparse mel filterbanks of MFE / MFCC blocks, see speechpy/mel_filterbank.hpp.
+// Filterbanks that don't fit are built on every call. 0 (default) leaves the cache out, so
+// impulses without audio blocks don't carry it, set it (e.g. 4096) for audio impulses.
+#ifndef EIDSP_MEL_FILTERBANK_CACHE_SIZE
+#define EIDSP_MEL_FILTERBANK_CACHE_SIZE        0
+#endif // EIDSP_MEL_FILTERBANK_CACHE_SIZE
+
+#ifndef EIDSP_MEL_FILTERBANK_CACHE_MAX_TABLES
+#define EIDSP_MEL_FILTERBANK_CACHE_MAX_TABLES  2
+#endif // EIDSP_MEL_FILTERBANK_CACHE_MAX_TABLES
+
+// Look up mel filterbanks in const (flash) tables generated with tools/mel-filterbank first,
+// the generated source defines ei_mel_filterbank_tables and has to be compiled in.
+#ifndef EIDSP_MEL_FILTERBANK_CONST_TABLES
+#define EIDSP_MEL_FILTERBANK_CONST_TABLES      0
+#endif // EIDSP_MEL_FILTERBANK_CONST_TABLES
+
 // prints buffer allocations to stdout, useful when debugging
 #ifndef EIDSP_TRACK_ALLOCATIONS
 #define EIDSP_TRACK_ALLOCATIONS      0
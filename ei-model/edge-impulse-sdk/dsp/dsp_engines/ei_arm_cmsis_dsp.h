@@ -216,6 +216,41 @@ static int hw_r2c_fft(const float *input, ei::fft_complex_t *output_as_complex,
     return ei::EIDSP_OK;
 }
 
+static bool can_do_fft_q15(size_t n_fft)
+{
+    return n_fft == 16 || can_do_fft(n_fft);
+}
+
+/**
+ * Real FFT of a q15 frame. Like arm_rfft_q15 the output is X / n_fft (CMSIS downscales
+ * by 2 in every stage), complex interleaved, bins 0..n_fft/2 are valid.
+ * The q15 RFFT needs at least 32 points, 16 points goes through the complex FFT.
+ * @param input Frame of n_fft items, modified by the transform
+ * @param output Out buffer, 2 * n_fft items
+ * @param n_fft FFT length
+ */
+static int hw_r2c_fft_q15(q15_t *input, q15_t *output, size_t n_fft)
+{
+    if (n_fft == 16) {
+        for (size_t ix = 0; ix < n_fft; ix++) {
+            output[2 * ix] = input[ix];
+            output[2 * ix + 1] = 0;
+        }
+        arm_cfft_q15(&arm_cfft_sR_q15_len16, output, 0, 1);
+        return ei::EIDSP_OK;
+    }
+
+    if (!can_do_fft(n_fft)) { return ei::EIDSP_FFT_SIZE_NOT_SUPPORTED; }
+
+    arm_rfft_instance_q15 rfft_instance;
+    if (arm_rfft_init_q15(&rfft_instance, n_fft, 0, 1) != ARM_MATH_SUCCESS) {
+        return ei::EIDSP_FFT_TABLE_NOT_LOADED;
+    }
+
+    arm_rfft_q15(&rfft_instance, input, output);
+    return ei::EIDSP_OK;
+}
+
 constexpr int MIN_FFT_SIZE = 32;
 constexpr int MAX_FFT_SIZE = 4096;
 
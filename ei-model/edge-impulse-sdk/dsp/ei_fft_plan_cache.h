@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef _EIDSP_FFT_PLAN_CACHE_H_
+#define _EIDSP_FFT_PLAN_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.hpp"
+#include "kissfft/kiss_fftr.h"
+
+namespace ei {
+
+/**
+ * Persistent kissfft plans for the FFT sizes that don't have a hardware (or table driven)
+ * implementation. Building a plan computes all twiddle factors, which used to happen on
+ * every numpy::rfft() call, i.e. for every Welch segment of every axis.
+ *
+ * Plans are carved from a static pool of EIDSP_FFT_PLAN_CACHE_SIZE bytes, so they never
+ * touch the heap (or the inference arena) and stay valid until clear(). Sizes that don't
+ * fit fall back to a plan per call.
+ */
+class fft_plan_cache {
+public:
+    /**
+     * Forward real FFT plan for n_fft, built on first use
+     * @param n_fft FFT length, must be even
+     * @returns the plan, or nullptr if it doesn't fit in the cache
+     */
+    static kiss_fftr_cfg get_rfft(size_t n_fft) {
+        cache_t *cache = get_cache();
+
+        for (size_t ix = 0; ix < cache->plan_count; ix++) {
+            if (cache->plans[ix].n_fft == n_fft) {
+                return cache->plans[ix].cfg;
+            }
+        }
+
+        if (cache->plan_count >= EIDSP_FFT_PLAN_CACHE_MAX_PLANS || (n_fft & 1)) {
+            return nullptr;
+        }
+
+        // query the size first, keep the pool 8 byte aligned for the twiddles
+        size_t mem_length = 0;
+        kiss_fftr_alloc((int)n_fft, 0, NULL, &mem_length);
+        mem_length = (mem_length + 7) & ~(size_t)7;
+        if (mem_length == 0 || cache->used + mem_length > EIDSP_FFT_PLAN_CACHE_SIZE) {
+            return nullptr;
+        }
+
+        kiss_fftr_cfg cfg = kiss_fftr_alloc((int)n_fft, 0,
+            (uint8_t *)cache->pool + cache->used, &mem_length);
+        if (!cfg) {
+            return nullptr;
+        }
+
+        cache->used += mem_length;
+        cache->plans[cache->plan_count].n_fft = n_fft;
+        cache->plans[cache->plan_count].cfg = cfg;
+        cache->plan_count++;
+        return cfg;
+    }
+
+    /**
+     * Drop all plans, they're rebuilt on the next use
+     */
+    static void clear() {
+        cache_t *cache = get_cache();
+        cache->plan_count = 0;
+        cache->used = 0;
+    }
+
+    /**
+     * @returns bytes of the pool in use
+     */
+    static size_t get_used_bytes() {
+        return get_cache()->used;
+    }
+
+private:
+    typedef struct {
+        size_t n_fft;
+        kiss_fftr_cfg cfg;
+    } plan_t;
+
+    typedef struct {
+        plan_t plans[EIDSP_FFT_PLAN_CACHE_MAX_PLANS];
+        size_t plan_count;
+        size_t used;
+        uint64_t pool[EIDSP_FFT_PLAN_CACHE_SIZE > 0 ? (EIDSP_FFT_PLAN_CACHE_SIZE + 7) / 8 : 1];
+    } cache_t;
+
+    // one instance for the whole program, and only linked in when a plan is requested
+    static cache_t *get_cache() {
+        static cache_t cache;
+        return &cache;
+    }
+};
+
+} // namespace ei
+
+#endif // _EIDSP_FFT_PLAN_CACHE_H_
@@ -41,12 +41,12 @@ public:
     }
     void reset()
     {
-        timestamp = ei_read_timer_ms();
+        timestamp = ei_read_timer_us();
     }
     void report(const char *message)
     {
-        ei_printf("%s took %llu\r\n", message, ei_read_timer_ms() - timestamp);
-        timestamp = ei_read_timer_ms(); //read again to not count printf time
+        ei_printf("%s took %llu us\r\n", message, ei_read_timer_us() - timestamp);
+        timestamp = ei_read_timer_us(); //read again to not count printf time
     }
 
 private:
@@ -60,6 +60,7 @@
 #include "memory.hpp"
 #include "ei_utils.h"
 #include "kissfft/kiss_fftr.h"
+#include "ei_fft_plan_cache.h"
 #include "edge-impulse-sdk/porting/ei_logging.h"
 
 // Checks for hardware math engines and associated kernel includes
@@ -1391,6 +1392,25 @@ public:
     }
 
 
+    /**
+     * Prepare rfft() for n_fft ahead of the first inference, e.g. build the kissfft plan
+     * when there's no hardware FFT of this size (see fft_plan_cache).
+     * @param n_fft FFT length
+     * @returns 0 if OK
+     */
+    static int rfft_init(size_t n_fft) {
+        const size_t n_fft_out_features = (n_fft / 2) + 1;
+
+        // a transform of silence (matrices are zeroed) takes the same path as real frames
+        EI_DSP_MATRIX(frame, 1, n_fft);
+
+        fft_complex_t *fft_output = NULL;
+        auto ptr = EI_MAKE_TRACKED_POINTER(fft_output, n_fft_out_features);
+        EI_ERR_AND_RETURN_ON_NULL(fft_output, EIDSP_OUT_OF_MEM);
+
+        return rfft(frame.buffer, n_fft, fft_output, n_fft_out_features, n_fft);
+    }
+
     /**
      * Return evenly spaced numbers over a specified interval.
      * Returns num evenly spaced samples, calculated over the interval [start, stop].
@@ -1787,6 +1807,15 @@ public:
     static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
     {
     #if EIDSP_INCLUDE_KISSFFT || !defined(EIDSP_INCLUDE_KISSFFT)
+    #if EIDSP_FFT_PLAN_CACHE_SIZE > 0
+        // plans are kept across calls, computing the twiddles dominates small FFTs
+        kiss_fftr_cfg cached_cfg = fft_plan_cache::get_rfft(n_fft);
+        if (cached_cfg) {
+            kiss_fftr(cached_cfg, fft_input, (kiss_fft_cpx*)output);
+            return EIDSP_OK;
+        }
+    #endif // EIDSP_FFT_PLAN_CACHE_SIZE > 0
+
         // create fftr context
         size_t kiss_fftr_mem_length;
 
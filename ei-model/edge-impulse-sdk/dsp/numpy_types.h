@@ -701,6 +701,22 @@ typedef struct ei_signal_t {
     size_t total_length;
 } signal_t;
 
+/**
+ * Raw int16 sensor counts, e.g. straight from an IMU. Same layout as signal_t (interleaved
+ * axes), `scale` converts counts to the units the impulse was trained on.
+ */
+typedef struct ei_signal_i16_t {
+#if EIDSP_SIGNAL_C_FN_POINTER == 1
+    int __attribute__((aligned(32))) (*get_data)(size_t, size_t, int16_t *);
+#else
+    std::function<int(size_t offset, size_t length, int16_t *out_ptr)> get_data;
+#endif // EIDSP_SIGNAL_C_FN_POINTER == 1
+
+    size_t total_length;
+
+    float scale;
+} signal_i16_t;
+
 /** @} */
 
 #ifdef __cplusplus
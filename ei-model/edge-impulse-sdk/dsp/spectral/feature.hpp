@@ -47,6 +47,21 @@ typedef enum {
     filter_highpass = 2
 } filter_t;
 
+/**
+ * Power spectra of the full Welch segments of earlier windows, so sliding windows
+ * (continuous classification) only FFT the segments that are new. A segment is
+ * identified by the stream index of its first sample, so spectra are only reused
+ * when the stride is a multiple of the segment hop.
+ */
+typedef struct {
+    float *spectra;         // [axis][slot][fft_length / 2 + 1]
+    uint64_t *keys;         // [axis][slot], stream index of the segment + 1, 0 = empty
+    size_t axes;
+    size_t slots;           // full segments per window
+    size_t bins;
+    uint64_t window_start;  // stream index of the first sample of the window
+} welch_segment_cache_t;
+
 class feature {
 public:
 
@@ -333,9 +348,94 @@ public:
         }
     }
 
+    /**
+     * Whether the Welch segment spectra of a config can be reused between windows.
+     * Only when nothing depends on the whole window: no filter (its state runs over the
+     * window), and no DC bin in the features (it depends on the window mean, v4 uses it).
+     */
+    static bool can_cache_welch_segments(ei_dsp_config_spectral_analysis_t *config)
+    {
+        bool has_filter = (strcmp(config->filter_type, "low") == 0 ||
+            strcmp(config->filter_type, "high") == 0) && config->filter_order > 0;
+
+        return strcmp(config->analysis_type, "FFT") == 0 &&
+            (config->implementation_version == 2 || config->implementation_version == 3) &&
+            !has_filter;
+    }
+
+    /**
+     * @returns the number of Welch segments of a window that don't need zero padding,
+     *  i.e. the slots of a welch_segment_cache_t
+     */
+    static size_t get_welch_segment_count(size_t window_samples, size_t fft_length, bool do_overlap)
+    {
+        const size_t hop = do_overlap ? fft_length / 2 : fft_length;
+        if (hop == 0 || window_samples < fft_length) {
+            return 0;
+        }
+        return (window_samples - fft_length) / hop + 1;
+    }
+
+    /**
+     * numpy::welch_max_hold() on one axis of a sliding window, taking the spectra of the
+     * full segments from the cache when an earlier window already calculated them.
+     * The input is not modified.
+     */
+    static int welch_max_hold_cached(
+        float *input,
+        size_t input_size,
+        float *output,
+        size_t start_bin,
+        size_t stop_bin,
+        size_t fft_points,
+        bool do_overlap,
+        welch_segment_cache_t *cache,
+        size_t axis)
+    {
+        const size_t fft_out_size = fft_points / 2 + 1;
+        const size_t hop = do_overlap ? fft_points / 2 : fft_points;
+
+        if (fft_out_size != cache->bins || axis >= cache->axes || cache->slots == 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        ei_vector<float> fft_out(fft_out_size);
+
+        memset(output, 0, sizeof(float) * (stop_bin - start_bin));
+        for (size_t input_ix = 0; input_ix < input_size; input_ix += hop) {
+            const float *spectrum;
+
+            if (input_ix + fft_points <= input_size) {
+                const uint64_t key = cache->window_start + input_ix + 1;
+                const size_t slot = axis * cache->slots + ((key - 1) / hop) % cache->slots;
+                float *cached = cache->spectra + slot * cache->bins;
+
+                if (cache->keys[slot] != key) {
+                    EI_TRY(numpy::power_spectrum(input + input_ix, fft_points, cached, fft_out_size, fft_points));
+                    cache->keys[slot] = key;
+                }
+                spectrum = cached;
+            }
+            else {
+                // zero padded, depends on the window mean, so never reused
+                EI_TRY(numpy::power_spectrum(input + input_ix, input_size - input_ix, fft_out.data(), fft_out_size, fft_points));
+                spectrum = fft_out.data();
+            }
+
+            // keep the max of the last frame and everything before
+            for (size_t i = start_bin; i < stop_bin; i++) {
+                output[i - start_bin] = std::max(output[i - start_bin], spectrum[i]);
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
     /**
      * @brief Calculates the spectral analysis features.
      *
+     * @param segment_cache Welch segments of earlier windows, or nullptr. Only for configs
+     *  where can_cache_welch_segments() holds.
      * @return the number of features calculated
      */
     static size_t extract_spec_features(
@@ -344,7 +444,8 @@ public:
         ei_dsp_config_spectral_analysis_t *config,
         const float sampling_freq,
         const bool remove_mean = true,
-        const bool transpose_and_scale_input = true)
+        const bool transpose_and_scale_input = true,
+        welch_segment_cache_t *segment_cache = nullptr)
     {
         if (transpose_and_scale_input) {
             // transpose the matrix so we have one row per axis
@@ -465,6 +566,17 @@ public:
                 for (size_t i = start_bin; i < stop_bin; i++) {
                     feature_out[i - start_bin] = fft_out[i];
                 }
+            } else if (segment_cache) {
+                EI_TRY(welch_max_hold_cached(
+                    data_window,
+                    data_size,
+                    feature_out,
+                    start_bin,
+                    stop_bin,
+                    config->fft_length,
+                    config->do_fft_overlap,
+                    segment_cache,
+                    row));
             } else {
                 EI_TRY(numpy::welch_max_hold(
                     data_window,
@@ -490,10 +602,11 @@ public:
         matrix_t *input_matrix,
         matrix_t *output_matrix,
         ei_dsp_config_spectral_analysis_t *config,
-        const float sampling_freq)
+        const float sampling_freq,
+        welch_segment_cache_t *segment_cache = nullptr)
     {
         size_t n_features =
-            extract_spec_features(input_matrix, output_matrix, config, sampling_freq);
+            extract_spec_features(input_matrix, output_matrix, config, sampling_freq, true, true, segment_cache);
         return n_features == output_matrix->cols ? EIDSP_OK : EIDSP_MATRIX_SIZE_MISMATCH;
     }
 
@@ -0,0 +1,473 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef _EIDSP_SPECTRAL_FEATURE_Q15_H_
+#define _EIDSP_SPECTRAL_FEATURE_Q15_H_
+
+#include "../config.hpp"
+
+#if EIDSP_USE_Q15_SPECTRAL == 1 && EIDSP_USE_CMSIS_DSP == 1
+
+#include <stdint.h>
+#include "feature.hpp"
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include "edge-impulse-sdk/dsp/dsp_engines/ei_arm_cmsis_dsp.h"
+
+namespace ei {
+namespace spectral {
+
+/**
+ * Fixed point version of feature::extract_spec_features (spectral analysis, FFT), for raw
+ * int16 sensor counts. Per axis the Butterworth filter runs as a q15 biquad cascade, the
+ * mean is removed in integer and the axis is block scaled to the full q15 range. RMS,
+ * skewness and kurtosis come from integer moments and the Welch max-hold from the q15 FFT.
+ * Only the final O(features) step (scaling back to units, log10) is float.
+ */
+class feature_q15 {
+public:
+
+    /**
+     * Whether the config can run in fixed point. Wavelets, v1 features, decimation and the
+     * extra low frequency features are only available through the float implementation.
+     */
+    static bool is_supported(const ei_dsp_config_spectral_analysis_t *config)
+    {
+        if (strcmp(config->analysis_type, "FFT") != 0) {
+            return false;
+        }
+        if (config->implementation_version < 2 || config->implementation_version > 4) {
+            return false;
+        }
+        if (config->implementation_version == 4 &&
+            (config->extra_low_freq || config->input_decimation_ratio != 1)) {
+            return false;
+        }
+        if (config->filter_order > (int)(2 * max_filter_stages)) {
+            return false;
+        }
+        return ei::fft::can_do_fft_q15(config->fft_length);
+    }
+
+    /**
+     * Calculate the spectral features over a signal of int16 counts.
+     * @param signal Interleaved counts (config->axes per frame), signal->scale converts
+     *  counts to the units the impulse was trained on
+     * @param output_matrix Output features, same layout as the float implementation
+     * @param config Spectral analysis config
+     * @param sampling_freq Sampling frequency of the signal
+     * @returns EIDSP_OK if OK
+     */
+    static int extract_spec_features(
+        signal_i16_t *signal,
+        matrix_t *output_matrix,
+        ei_dsp_config_spectral_analysis_t *config,
+        const float sampling_freq)
+    {
+        if (!is_supported(config)) {
+            EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+        }
+
+        const size_t axes = config->axes;
+        if (axes == 0 || signal->total_length % axes != 0) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+        const size_t n = signal->total_length / axes;
+        if (n == 0 || n > 0xffff) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        bool do_filter = false;
+        bool is_high_pass = false;
+        if (strcmp(config->filter_type, "low") == 0) {
+            do_filter = true;
+        }
+        else if (strcmp(config->filter_type, "high") == 0) {
+            do_filter = true;
+            is_high_pass = true;
+        }
+
+        size_t start_bin, stop_bin;
+        if (do_filter) {
+            feature::get_start_stop_bin(
+                sampling_freq,
+                config->fft_length,
+                config->filter_cutoff,
+                &start_bin,
+                &stop_bin,
+                is_high_pass);
+        }
+        else {
+            start_bin = 1;
+            stop_bin = config->fft_length / 2 + 1;
+        }
+        const size_t num_bins = stop_bin - start_bin;
+        const size_t fft_out_size = config->fft_length / 2 + 1;
+        const bool is_v4 = config->implementation_version == 4;
+
+        const size_t features_per_axis = 3 + (is_v4 ? 2 : 0) + num_bins;
+        if (output_matrix->rows * output_matrix->cols != axes * features_per_axis) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        // one row of counts per axis
+        int16_t *rows = nullptr;
+        auto rows_ptr = EI_MAKE_TRACKED_POINTER(rows, axes * n);
+        if (!rows) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        EI_TRY(gather_rows(signal, rows, axes, n));
+
+        // v4 needs the full spectrum for the spectral skew and kurtosis
+        const size_t lo_bin = is_v4 ? 0 : start_bin;
+        const size_t hi_bin = is_v4 ? fft_out_size : stop_bin;
+        uint64_t *max_hold = nullptr;
+        auto max_hold_ptr = EI_MAKE_TRACKED_POINTER(max_hold, hi_bin - lo_bin);
+        float *power = nullptr;
+        auto power_ptr = EI_MAKE_TRACKED_POINTER(power, hi_bin - lo_bin);
+        if (!max_hold || !power) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        const float units_per_count = signal->scale * config->scale_axes;
+
+        float *feature_out = output_matrix->buffer;
+        for (size_t axis = 0; axis < axes; axis++) {
+            int16_t *x = rows + axis * n;
+            // units per LSB of x
+            float unit = units_per_count;
+
+            if (do_filter && config->filter_order >= 2) {
+                EI_TRY(butterworth_q15(
+                    x,
+                    n,
+                    sampling_freq,
+                    config->filter_cutoff,
+                    config->filter_order,
+                    is_high_pass,
+                    &unit));
+            }
+
+            remove_mean(x, n, &unit);
+
+            // RMS (same as the standard deviation, the mean is zero)
+            int64_t sum_sq = 0;
+            for (size_t i = 0; i < n; i++) {
+                sum_sq += (int32_t)x[i] * x[i];
+            }
+            *feature_out++ = sqrtf((float)sum_sq / n) * unit;
+
+            moments(x, n, feature_out);
+            feature_out += 2;
+
+            EI_TRY(welch_max_hold(
+                x,
+                n,
+                max_hold,
+                lo_bin,
+                hi_bin,
+                config->fft_length,
+                config->do_fft_overlap));
+
+            // the FFT output is X / n_fft, so |X|^2 / n_fft is n_fft * |out|^2
+            const float gain = (float)config->fft_length * unit * unit / (float)(1UL << 30);
+            for (size_t i = 0; i < hi_bin - lo_bin; i++) {
+                power[i] = (float)max_hold[i] * gain;
+            }
+
+            if (is_v4) {
+                matrix_t x_matrix(1, fft_out_size, power);
+                matrix_t out(1, 1);
+
+                *feature_out++ = (numpy::skew(&x_matrix, &out) == EIDSP_OK) ? (out.get_row_ptr(0)[0]) : 0.0f;
+                *feature_out++ = (numpy::kurtosis(&x_matrix, &out) == EIDSP_OK) ? (out.get_row_ptr(0)[0]) : 0.0f;
+            }
+
+            for (size_t i = start_bin; i < stop_bin; i++) {
+                feature_out[i - start_bin] = power[i - lo_bin];
+            }
+            if (config->do_log) {
+                numpy::zero_handling(feature_out, num_bins);
+                ei_matrix temp(num_bins, 1, feature_out);
+                numpy::log10(&temp);
+            }
+            feature_out += num_bins;
+        }
+
+        return EIDSP_OK;
+    }
+
+private:
+    static constexpr size_t max_filter_stages = 4;
+    static constexpr size_t gather_frames = 32;
+
+    /**
+     * Shift that brings absmax into [2^(bits - 1), 2^bits), negative is a right shift
+     */
+    static int norm_shift(uint64_t absmax, int bits)
+    {
+        if (absmax == 0) {
+            return 0;
+        }
+        int shift = 0;
+        while (absmax >= (1ULL << bits)) {
+            absmax >>= 1;
+            shift--;
+        }
+        while (absmax < (1ULL << (bits - 1))) {
+            absmax <<= 1;
+            shift++;
+        }
+        return shift;
+    }
+
+    static int32_t shift_round(int64_t v, int shift)
+    {
+        if (shift >= 0) {
+            return (int32_t)(v << shift);
+        }
+        return (int32_t)((v + (1LL << (-shift - 1))) >> -shift);
+    }
+
+    static int16_t sat_q15(int32_t v)
+    {
+        return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+    }
+
+    /**
+     * De-interleave the signal into one row per axis, a few frames at a time
+     */
+    static int gather_rows(signal_i16_t *signal, int16_t *rows, size_t axes, size_t n)
+    {
+        int16_t *chunk = nullptr;
+        auto chunk_ptr = EI_MAKE_TRACKED_POINTER(chunk, gather_frames * axes);
+        if (!chunk) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        for (size_t frame = 0; frame < n; frame += gather_frames) {
+            size_t frames = n - frame < gather_frames ? n - frame : gather_frames;
+            int r = signal->get_data(frame * axes, frames * axes, chunk);
+            if (r != 0) {
+                EIDSP_ERR(r);
+            }
+            for (size_t f = 0; f < frames; f++) {
+                for (size_t axis = 0; axis < axes; axis++) {
+                    rows[axis * n + frame + f] = chunk[f * axes + axis];
+                }
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Same sections as filters::butterworth_lowpass / butterworth_highpass, run with
+     * arm_biquad_cascade_df1_q15. Coefficients are q14 (postShift 1) as |a1| approaches 2,
+     * the input is scaled to 2 bits below full range as the sections peak before the
+     * cascade is flat.
+     * @param x Row, filtered in place
+     * @param unit Units per LSB of x, updated for the scaling
+     */
+    static int butterworth_q15(
+        int16_t *x,
+        size_t n,
+        float sampling_freq,
+        float cutoff_freq,
+        int filter_order,
+        bool is_high_pass,
+        float *unit)
+    {
+        const int n_steps = filter_order / 2;
+        q15_t coeffs[6 * max_filter_stages];
+        q15_t state[4 * max_filter_stages] = { 0 };
+
+        const float a = tan(M_PI * cutoff_freq / sampling_freq);
+        const float a2 = a * a;
+        for (int ix = 0; ix < n_steps; ix++) {
+            float r = sin(M_PI * ((2.0 * ix) + 1.0) / (2.0 * filter_order));
+            float den = a2 + (2.0 * a * r) + 1.0;
+            float gain = is_high_pass ? 1.0f / den : a2 / den;
+            float d1 = 2.0 * (1 - a2) / den;
+            float d2 = -(a2 - (2.0 * a * r) + 1.0) / den;
+
+            q15_t *c = &coeffs[6 * ix];
+            c[0] = sat_q15(lrintf(gain * 16384.0f));
+            c[1] = 0;
+            c[2] = sat_q15(lrintf((is_high_pass ? -2.0f : 2.0f) * gain * 16384.0f));
+            c[3] = c[0];
+            c[4] = sat_q15(lrintf(d1 * 16384.0f));
+            c[5] = sat_q15(lrintf(d2 * 16384.0f));
+        }
+
+        int32_t absmax = 0;
+        for (size_t i = 0; i < n; i++) {
+            int32_t v = x[i] < 0 ? -x[i] : x[i];
+            absmax = v > absmax ? v : absmax;
+        }
+        const int shift = norm_shift(absmax, 13);
+        for (size_t i = 0; i < n; i++) {
+            x[i] = sat_q15(shift_round(x[i], shift));
+        }
+        *unit = ldexpf(*unit, -shift);
+
+        arm_biquad_casd_df1_inst_q15 biquad;
+        arm_biquad_cascade_df1_init_q15(&biquad, n_steps, coeffs, state, 1);
+        arm_biquad_cascade_df1_q15(&biquad, x, x, n);
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Subtract the mean and block scale the row to [2^14, 2^15).
+     * x * n - sum is exact, so there's only a single rounding.
+     */
+    static void remove_mean(int16_t *x, size_t n, float *unit)
+    {
+        int32_t sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += x[i];
+        }
+
+        uint64_t absmax = 0;
+        for (size_t i = 0; i < n; i++) {
+            int64_t v = (int64_t)x[i] * n - sum;
+            uint64_t a = v < 0 ? -v : v;
+            absmax = a > absmax ? a : absmax;
+        }
+
+        const int shift = norm_shift(absmax, 15);
+        for (size_t i = 0; i < n; i++) {
+            x[i] = sat_q15(shift_round((int64_t)x[i] * n - sum, shift));
+        }
+        *unit = ldexpf(*unit / n, -shift);
+    }
+
+    /**
+     * Skewness and (Fisher) kurtosis, see feature::extract_spec_features. The sums of
+     * x^3 and x^4 are int64, so x is reduced to fit the number of samples. The unit
+     * cancels out.
+     */
+    static void moments(const int16_t *x, size_t n, float *out)
+    {
+        int n_bits = 0;
+        while (((size_t)1 << n_bits) < n) {
+            n_bits++;
+        }
+        int shift = 0;
+        while (4 * (15 - shift) + n_bits > 62) {
+            shift++;
+        }
+
+        int64_t s2 = 0, s3 = 0, s4 = 0;
+        for (size_t i = 0; i < n; i++) {
+            int64_t v = shift_round(x[i], -shift);
+            int64_t v2 = v * v;
+            s2 += v2;
+            s3 += v2 * v;
+            s4 += v2 * v2;
+        }
+
+        float stddev = sqrtf((float)s2 / n);
+        if (stddev == 0.0f) {
+            stddev = 1e-10f;
+        }
+        float temp = stddev * stddev * stddev;
+        out[0] = ((float)s3 / n) / temp;
+        out[1] = (((float)s4 / n) / (temp * stddev)) - 3;
+    }
+
+    /**
+     * numpy::welch_max_hold on a q15 row. Every segment is scaled to the full q15 range
+     * before its FFT, the max is held in a common scale: |out|^2 * 2^30 of the unscaled row.
+     * @param output Out buffer, stop_bin - start_bin items
+     */
+    static int welch_max_hold(
+        const int16_t *input,
+        size_t input_size,
+        uint64_t *output,
+        size_t start_bin,
+        size_t stop_bin,
+        size_t fft_points,
+        bool do_overlap)
+    {
+        q15_t *fft_buffer = nullptr;
+        auto fft_buffer_ptr = EI_MAKE_TRACKED_POINTER(fft_buffer, 3 * fft_points);
+        if (!fft_buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        q15_t *fft_input = fft_buffer;
+        q15_t *fft_output = fft_buffer + fft_points;
+
+        memset(output, 0, sizeof(uint64_t) * (stop_bin - start_bin));
+
+        const size_t step = do_overlap ? fft_points / 2 : fft_points;
+        for (size_t input_ix = 0; input_ix < input_size; input_ix += step) {
+            size_t n_input_points = input_ix + fft_points <= input_size ? fft_points
+                                                                        : input_size - input_ix;
+
+            int32_t absmax = 0;
+            for (size_t i = 0; i < n_input_points; i++) {
+                int32_t v = input[input_ix + i];
+                v = v < 0 ? -v : v;
+                absmax = v > absmax ? v : absmax;
+            }
+            if (absmax == 0) {
+                continue;
+            }
+            // -32768 would ask for a right shift
+            int shift = norm_shift(absmax, 15);
+            shift = shift < 0 ? 0 : (shift > 15 ? 15 : shift);
+
+            for (size_t i = 0; i < n_input_points; i++) {
+                fft_input[i] = sat_q15((int32_t)input[input_ix + i] << shift);
+            }
+            memset(fft_input + n_input_points, 0, (fft_points - n_input_points) * sizeof(q15_t));
+
+            EI_TRY(ei::fft::hw_r2c_fft_q15(fft_input, fft_output, fft_points));
+
+            for (size_t i = start_bin; i < stop_bin; i++) {
+                const int32_t re = fft_output[2 * i];
+                const int32_t im = fft_output[2 * i + 1];
+                const uint64_t mag2 = (uint64_t)((uint32_t)(re * re) + (uint32_t)(im * im))
+                    << (30 - 2 * shift);
+                output[i - start_bin] = std::max(output[i - start_bin], mag2);
+            }
+        }
+
+        return EIDSP_OK;
+    }
+};
+
+} // namespace spectral
+} // namespace ei
+
+#endif // EIDSP_USE_Q15_SPECTRAL == 1 && EIDSP_USE_CMSIS_DSP == 1
+
+#endif // _EIDSP_SPECTRAL_FEATURE_Q15_H_
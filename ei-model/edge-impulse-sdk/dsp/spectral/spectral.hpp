@@ -34,5 +34,6 @@
 #include "../config.hpp"
 #include "processing.hpp"
 #include "feature.hpp"
+#include "feature_q15.hpp"
 
 #endif // _EIDSP_SPECTRAL_SPECTRAL_H_
@@ -35,6 +35,7 @@
 #include "../../porting/ei_classifier_porting.h"
 #include "../ei_utils.h"
 #include "functions.hpp"
+#include "mel_filterbank.hpp"
 #include "processing.hpp"
 #include "../memory.hpp"
 #include "../returntypes.hpp"
@@ -193,6 +194,43 @@ public:
         return static_cast<int>(floor((fft_size + 1) * hertz / sampling_freq));
     }
 
+    /**
+     * @brief Get the sparse mel filterbank for a configuration, from mel_filterbank_cache,
+     * or built for this call only if it doesn't fit there
+     *
+     * @param config Configuration part of the filterbank (defaults already applied),
+     *               holds the tables when built for this call
+     * @param filterbank Out: the filterbank
+     * @param filterbank_mem Owns the memory of a filterbank built for this call
+     * @return int EIDSP_OK if OK
+     */
+    static int get_mel_filterbank(mel_filterbank_t *config, const mel_filterbank_t **filterbank,
+        ei_unique_ptr_t &filterbank_mem)
+    {
+        *filterbank = mel_filterbank_cache::get(config);
+        if (*filterbank) {
+            return EIDSP_OK;
+        }
+
+        size_t mem_size = 0;
+        int ret = mel_filterbank::get_mem_size(config, &mem_size);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        void *mem = ei_dsp_calloc(mem_size, 1);
+        EI_ERR_AND_RETURN_ON_NULL(mem, EIDSP_OUT_OF_MEM);
+        filterbank_mem = ei_unique_ptr_t(mem, [mem_size](void *ptr) { ei::ei_dsp_free_func(ptr, mem_size); });
+
+        ret = mel_filterbank::create(config, mem, mem_size);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        *filterbank = config;
+        return EIDSP_OK;
+    }
+
     /**
      * Compute Mel-filterbank energy features from an audio signal.
      * @param out_features Use `calculate_mfe_buffer_size` to allocate the right matrix.
@@ -267,47 +305,18 @@ public:
         }
 
         const size_t power_spectrum_frame_size = (fft_length / 2 + 1);
-        // Computing the Mel filterbank
-        // converting the upper and lower frequencies to Mels.
-        // num_filter + 2 is because for num_filter filterbanks we need
-        // num_filter+2 point.
-        float *mels;
-        const int MELS_SIZE = num_filters + 2;
-        const size_t mem_size = MELS_SIZE * sizeof(float);
-        mels = (float*)ei_dsp_calloc(MELS_SIZE, sizeof(float));
-        EI_ERR_AND_RETURN_ON_NULL(mels, EIDSP_OUT_OF_MEM);
-        ei_unique_ptr_t __ptr__(mels,[mem_size](void* ptr){ei::ei_dsp_free_func(ptr, mem_size);});
-        uint16_t* bins = reinterpret_cast<uint16_t*>(mels); // alias the mels array so we can reuse the space
-
-        numpy::linspace(
-            functions::frequency_to_mel(static_cast<float>(low_frequency)),
-            functions::frequency_to_mel(static_cast<float>(high_frequency)),
-            num_filters + 2,
-            mels);
 
-        uint16_t max_bin = version >= 4 ? fft_length : power_spectrum_frame_size; // preserve a bug in v<4
-        // go to -1 size b/c special handling, see after
-        for (uint16_t ix = 0; ix < MELS_SIZE-1; ix++) {
-            mels[ix] = functions::mel_to_frequency(mels[ix]);
-            if (mels[ix] < low_frequency) {
-                mels[ix] = low_frequency;
-            }
-            if (mels[ix] > high_frequency) {
-                mels[ix] = high_frequency;
-            }
-            bins[ix] = get_fft_bin_from_hertz(max_bin, mels[ix], sampling_frequency);
-        }
-
-        // here is a really annoying bug in Speechpy which calculates the frequency index wrong for the last bucket
-        // the last 'hertz' value is not 8,000 (with sampling rate 16,000) but 7,999.999999
-        // thus calculating the bucket to 64, not 65.
-        // we're adjusting this here a tiny bit to ensure we have the same result
-        mels[MELS_SIZE-1] = functions::mel_to_frequency(mels[MELS_SIZE-1]);
-        if (mels[MELS_SIZE-1] > high_frequency) {
-            mels[MELS_SIZE-1] = high_frequency;
+        // the mel filterbank, computed once per configuration
+        mel_filterbank_t filterbank_config = {
+            MEL_FILTERBANK_TRIANGLE, version, sampling_frequency, low_frequency, high_frequency,
+            fft_length, num_filters, nullptr, nullptr, nullptr
+        };
+        const mel_filterbank_t *filterbank;
+        ei_unique_ptr_t filterbank_mem;
+        ret = get_mel_filterbank(&filterbank_config, &filterbank, filterbank_mem);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
         }
-        mels[MELS_SIZE-1] -= 0.001;
-        bins[MELS_SIZE-1] = get_fft_bin_from_hertz(max_bin, mels[MELS_SIZE-1], sampling_frequency);
 
         EI_DSP_MATRIX(power_spectrum_frame, 1, power_spectrum_frame_size);
         if (!power_spectrum_frame.buffer) {
@@ -356,34 +365,8 @@ public:
                 out_energies->buffer[ix] = energy;
             }
 
-            auto row_ptr = out_features->get_row_ptr(ix);
-            for (size_t i = 0; i < num_filters; i++) {
-                size_t left = bins[i];
-                size_t middle = bins[i+1];
-                size_t right = bins[i+2];
-
-                assert(right < power_spectrum_frame_size);
-                // now we have weights and locations to move from fft to mel sgram
-                // both left and right become zero weights, so skip them
-
-                // middle always has weight of 1.0
-                // since we skip left and right, if left = middle we need to handle that
-                row_ptr[i] = power_spectrum_frame.buffer[middle];
-
-                for (size_t bin = left+1; bin < right; bin++) {
-                    if (bin < middle) {
-                        row_ptr[i] +=
-                            ((static_cast<float>(bin) - left) / (middle - left)) * // weight *
-                            power_spectrum_frame.buffer[bin];
-                    }
-                    // intentionally skip middle, handled above
-                    if (bin > middle) {
-                        row_ptr[i] +=
-                            ((right - static_cast<float>(bin)) / (right - middle)) * // weight *
-                            power_spectrum_frame.buffer[bin];
-                    }
-                }
-            }
+            // only the non-zero span of every triangle is stored
+            mel_filterbank::apply(filterbank, power_spectrum_frame.buffer, out_features->get_row_ptr(ix));
 
             if (ret != 0) {
                 EIDSP_ERR(ret);
@@ -466,24 +449,18 @@ public:
             *(out_features->buffer + i) = 0;
         }
 
-        uint16_t coefficients = fft_length / 2 + 1;
-
-        // calculate the filterbanks first... preferably I would want to do the matrix multiplications
-        // whenever they happen, but OK...
-#if EIDSP_QUANTIZE_FILTERBANK
-        EI_DSP_QUANTIZED_MATRIX(filterbanks, num_filters, coefficients, &numpy::dequantize_zero_one);
-#else
-        EI_DSP_MATRIX(filterbanks, num_filters, coefficients);
-#endif
-        if (!filterbanks.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
-        ret = feature::filterbanks(
-            &filterbanks, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency, true);
-        if (ret != 0) {
+        // the filterbanks() weights in sparse form, computed once per configuration
+        mel_filterbank_t filterbank_config = {
+            MEL_FILTERBANK_SPEECHPY, version, sampling_frequency, low_frequency, high_frequency,
+            fft_length, num_filters, nullptr, nullptr, nullptr
+        };
+        const mel_filterbank_t *filterbank;
+        ei_unique_ptr_t filterbank_mem;
+        ret = get_mel_filterbank(&filterbank_config, &filterbank, filterbank_mem);
+        if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
         }
+
         for (size_t ix = 0; ix < stack_frame_info.frame_ixs.size(); ix++) {
             size_t power_spectrum_frame_size = (fft_length / 2 + 1);
 
@@ -534,17 +511,7 @@ public:
             }
 
             // calculate the out_features directly here
-            ret = numpy::dot_by_row(
-                ix,
-                power_spectrum_frame.buffer,
-                power_spectrum_frame_size,
-                &filterbanks,
-                out_features
-            );
-
-            if (ret != 0) {
-                EIDSP_ERR(ret);
-            }
+            mel_filterbank::apply(filterbank, power_spectrum_frame.buffer, out_features->get_row_ptr(ix));
         }
 
         numpy::zero_handling(out_features);
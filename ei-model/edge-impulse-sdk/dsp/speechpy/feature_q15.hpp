@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the currently selected SDK variation.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * You should have received a copy of the License with this Software. If not,
+ * please contact Edge Impulse to obtain a copy of the License.
+ */
+
+#ifndef _EIDSP_SPEECHPY_FEATURE_Q15_H_
+#define _EIDSP_SPEECHPY_FEATURE_Q15_H_
+
+#include "../config.hpp"
+
+#if EIDSP_USE_Q15_MFE == 1 && EIDSP_USE_CMSIS_DSP == 1
+
+#include <stdint.h>
+#include "feature.hpp"
+#include "model-parameters/model_metadata.h"
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include "edge-impulse-sdk/dsp/dsp_engines/ei_arm_cmsis_dsp.h"
+
+namespace ei {
+namespace speechpy {
+
+/**
+ * Fixed point version of the MFE block (v3 and up), for int16 audio samples. Per frame the
+ * pre-emphasis runs in integer, the frame is block scaled to the full q15 range and goes
+ * through the q15 RFFT, the mel energies are accumulated from |X|^2 with q15 filterbank
+ * weights. Only the per-feature step (log10 and the noise floor normalization) is float.
+ * Nothing is kept per sample or per bin in float: the working set is the q15 FFT buffer
+ * (3 * fft_length items) and the q15 weights.
+ */
+class feature_q15 {
+public:
+
+    /**
+     * Whether the config can run in fixed point. MFE v1 and v2 (speechpy filterbanks,
+     * cmvnw) are only available through the float implementation.
+     */
+    static bool is_supported(const ei_dsp_config_mfe_t *config)
+    {
+        if (config->axes != 1) {
+            return false;
+        }
+        if (config->implementation_version < 3 || config->implementation_version > 4) {
+            return false;
+        }
+        return config->fft_length >= ei::fft::MIN_FFT_SIZE && ei::fft::can_do_fft_q15(config->fft_length);
+    }
+
+    /**
+     * Calculate the (normalized) MFE features over int16 audio samples.
+     * @param signal Audio samples, signal->scale is ignored (the float path uses the raw values too)
+     * @param output_matrix Output features, frames x num_filters, same values as the float
+     *  implementation (multiples of 1/256 in [0, 1])
+     * @param config MFE config
+     * @param sampling_frequency Sampling frequency of the signal
+     * @returns EIDSP_OK if OK
+     */
+    static int extract_mfe_features(
+        signal_i16_t *signal,
+        matrix_t *output_matrix,
+        ei_dsp_config_mfe_t *config,
+        const float sampling_frequency)
+    {
+        return mfe(signal, output_matrix->buffer, output_matrix->rows * output_matrix->cols,
+            config, sampling_frequency);
+    }
+
+private:
+    // 0.98, the pre-emphasis coefficient of feature::mfe(), in q15
+    static constexpr int32_t preemphasis_q15 = 32113;
+
+    static int mfe(
+        signal_i16_t *signal,
+        float *out,
+        size_t out_size,
+        ei_dsp_config_mfe_t *config,
+        const float sampling_frequency)
+    {
+        if (!is_supported(config)) {
+            EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+        }
+        if (signal->total_length == 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        const uint32_t frequency = static_cast<uint32_t>(sampling_frequency);
+        const size_t fft_length = config->fft_length;
+
+        // only the frame positions are needed, stack_frames() doesn't read the signal
+        signal_t frames_signal;
+        frames_signal.total_length = signal->total_length;
+        frames_signal.get_data = [](size_t, size_t, float *) {
+            return (int)EIDSP_NOT_SUPPORTED;
+        };
+        stack_frames_info_t stack_frame_info = { 0 };
+        stack_frame_info.signal = &frames_signal;
+        EI_TRY(processing::stack_frames(
+            &stack_frame_info,
+            frequency,
+            config->frame_length,
+            config->frame_stride,
+            false,
+            config->implementation_version));
+
+        const size_t num_filters = config->num_filters;
+        if (stack_frame_info.frame_ixs.size() * num_filters != out_size) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        mel_filterbank_t filterbank_config = {
+            MEL_FILTERBANK_TRIANGLE, config->implementation_version, frequency,
+            (uint32_t)config->low_frequency, (uint32_t)config->high_frequency,
+            (uint16_t)fft_length, (uint16_t)num_filters, nullptr, nullptr, nullptr
+        };
+        mel_filterbank::resolve_config(&filterbank_config);
+        const mel_filterbank_t *filterbank;
+        ei_unique_ptr_t filterbank_mem;
+        EI_TRY(feature::get_mel_filterbank(&filterbank_config, &filterbank, filterbank_mem));
+
+        size_t weights_count = 0;
+        for (size_t ix = 0; ix < num_filters; ix++) {
+            weights_count += filterbank->bin_count[ix];
+        }
+        q15_t *weights = nullptr;
+        auto weights_ptr = EI_MAKE_TRACKED_POINTER(weights, weights_count);
+        // input is modified by the RFFT, output holds the full complex spectrum
+        q15_t *fft_buffer = nullptr;
+        auto fft_buffer_ptr = EI_MAKE_TRACKED_POINTER(fft_buffer, 3 * fft_length);
+        if (!weights || !fft_buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        q15_t *fft_input = fft_buffer;
+        q15_t *fft_output = fft_buffer + fft_length;
+
+        for (size_t ix = 0; ix < weights_count; ix++) {
+            weights[ix] = sat_q15((int32_t)lrintf(filterbank->weights[ix] * 32768.0f));
+        }
+
+        // samples beyond fft_length are cut off by the FFT anyway
+        const size_t frame_length = (size_t)stack_frame_info.frame_length < fft_length ?
+            (size_t)stack_frame_info.frame_length : fft_length;
+
+        // the pre-emphasis of the first sample wraps around to the last one
+        int16_t last_sample;
+        EI_TRY(get_samples(signal, signal->total_length - 1, 1, &last_sample));
+
+        const float noise = static_cast<float>(config->noise_floor_db * -1);
+        const float noise_scale = 1.0f / (static_cast<float>(config->noise_floor_db * -1) + 12.0f);
+
+        for (size_t frame = 0; frame < stack_frame_info.frame_ixs.size(); frame++) {
+            const size_t offset = stack_frame_info.frame_ixs[frame];
+            if (offset + frame_length > signal->total_length) {
+                EIDSP_ERR(EIDSP_OUT_OF_BOUNDS);
+            }
+
+            int16_t prev = last_sample;
+            if (offset > 0) {
+                EI_TRY(get_samples(signal, offset - 1, 1, &prev));
+            }
+            EI_TRY(get_samples(signal, offset, frame_length, fft_input));
+
+            // x[n] * 2^15 - 0.98 * x[n - 1] * 2^15 fits int32, scaled to the full q15 range
+            uint32_t absmax = 0;
+            for (size_t i = 0; i < frame_length; i++) {
+                int32_t v = preemphasize(fft_input[i], i > 0 ? fft_input[i - 1] : prev);
+                uint32_t a = v < 0 ? -(uint32_t)v : (uint32_t)v;
+                absmax = a > absmax ? a : absmax;
+            }
+            const int shift = norm_shift(absmax, 15);
+            // backwards, so x[n - 1] is still there
+            for (size_t i = frame_length; i-- > 0;) {
+                int32_t v = preemphasize(fft_input[i], i > 0 ? fft_input[i - 1] : prev);
+                fft_input[i] = sat_q15(shift_round(v, shift));
+            }
+            memset(fft_input + frame_length, 0, (fft_length - frame_length) * sizeof(q15_t));
+
+            EI_TRY(ei::fft::hw_r2c_fft_q15(fft_input, fft_output, fft_length));
+
+            // the frame is x * 2^(30 + shift) (float path: x / 2^15), the FFT output is X / n_fft,
+            // so |X|^2 / n_fft is n_fft * |out|^2 * 2^(-2 * (30 + shift)), weights are 2^15
+            const float gain = ldexpf((float)fft_length, -2 * (30 + shift) - 15);
+
+            const q15_t *w = weights;
+            for (size_t ix = 0; ix < num_filters; ix++) {
+                const size_t start = filterbank->bin_start[ix];
+                const size_t count = filterbank->bin_count[ix];
+
+                uint64_t sum = 0;
+                for (size_t bin = start; bin < start + count; bin++) {
+                    const int32_t re = fft_output[2 * bin];
+                    const int32_t im = fft_output[2 * bin + 1];
+                    sum += (uint64_t)((uint32_t)(re * re) + (uint32_t)(im * im)) * (uint16_t)*w++;
+                }
+
+                // same as numpy::zero_handling() and processing::mfe_normalization()
+                float f = sum > 0 ? (float)sum * gain : 1e-10f;
+                if (f < 1e-30f) {
+                    f = 1e-30f;
+                }
+                f = (10.0f * numpy::log10(f) + noise) * noise_scale;
+                f = roundf(f * 256) / 256;
+                f = f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+
+                out[frame * num_filters + ix] = f;
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
+    static int get_samples(signal_i16_t *signal, size_t offset, size_t length, int16_t *out)
+    {
+        int r = signal->get_data(offset, length, out);
+        if (r != 0) {
+            EIDSP_ERR(r);
+        }
+        return EIDSP_OK;
+    }
+
+    static inline int32_t preemphasize(int16_t now, int16_t prev)
+    {
+        return (int32_t)now * 32768 - preemphasis_q15 * prev;
+    }
+
+    /**
+     * Shift that brings absmax into [2^(bits - 1), 2^bits), negative is a right shift
+     */
+    static int norm_shift(uint32_t absmax, int bits)
+    {
+        if (absmax == 0) {
+            return 0;
+        }
+        int shift = 0;
+        while (absmax >= (1UL << bits)) {
+            absmax >>= 1;
+            shift--;
+        }
+        while (absmax < (1UL << (bits - 1))) {
+            absmax <<= 1;
+            shift++;
+        }
+        return shift;
+    }
+
+    static int32_t shift_round(int32_t v, int shift)
+    {
+        if (shift >= 0) {
+            return v << shift;
+        }
+        return (int32_t)(((int64_t)v + (1LL << (-shift - 1))) >> -shift);
+    }
+
+    static int16_t sat_q15(int32_t v)
+    {
+        return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+    }
+};
+
+} // namespace speechpy
+} // namespace ei
+
+#endif // EIDSP_USE_Q15_MFE == 1 && EIDSP_USE_CMSIS_DSP == 1
+
+#endif // _EIDSP_SPEECHPY_FEATURE_Q15_H_
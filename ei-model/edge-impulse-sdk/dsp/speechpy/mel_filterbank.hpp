@@ -0,0 +1,443 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef _EIDSP_SPEECHPY_MEL_FILTERBANK_H_
+#define _EIDSP_SPEECHPY_MEL_FILTERBANK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "../config.hpp"
+#include "../memory.hpp"
+#include "../numpy.hpp"
+#include "../returntypes.hpp"
+#include "functions.hpp"
+
+namespace ei {
+namespace speechpy {
+
+typedef enum {
+    // the triangles of feature::mfe(), i.e. MFE v3+ and MFCC
+    MEL_FILTERBANK_TRIANGLE = 0,
+    // feature::filterbanks() as used by feature::mfe_v3(), i.e. MFE v1 and v2
+    MEL_FILTERBANK_SPEECHPY = 1
+} mel_filterbank_type_t;
+
+/**
+ * Mel filterbank in compressed sparse form. Filter ix covers the power spectrum bins
+ * bin_start[ix] .. bin_start[ix] + bin_count[ix] - 1, its weights directly follow the
+ * weights of filter ix - 1. The first fields are the configuration the weights were
+ * built for (after mel_filterbank::resolve_config()).
+ */
+typedef struct {
+    uint8_t type;
+    uint16_t version;
+    uint32_t sampling_frequency;
+    uint32_t low_frequency;
+    uint32_t high_frequency;
+    uint16_t fft_length;
+    uint16_t num_filters;
+    const uint16_t *bin_start;
+    const uint16_t *bin_count;
+    const float *weights;
+} mel_filterbank_t;
+
+} // namespace speechpy
+} // namespace ei
+
+#if EIDSP_MEL_FILTERBANK_CONST_TABLES == 1
+// generated with tools/mel-filterbank, see README.md
+extern const ei::speechpy::mel_filterbank_t ei_mel_filterbank_tables[];
+extern const size_t ei_mel_filterbank_tables_size;
+#endif // EIDSP_MEL_FILTERBANK_CONST_TABLES
+
+namespace ei {
+namespace speechpy {
+
+class mel_filterbank {
+public:
+    /**
+     * Apply the defaults feature::mfe() / feature::mfe_v3() use for the band edges
+     * @param config Configuration part of a filterbank, updated in place
+     */
+    static void resolve_config(mel_filterbank_t *config) {
+        if (config->high_frequency == 0) {
+            config->high_frequency = config->sampling_frequency / 2;
+        }
+        if (config->low_frequency == 0 &&
+                (config->type == MEL_FILTERBANK_SPEECHPY || config->version < 4)) {
+            config->low_frequency = 300;
+        }
+    }
+
+    /**
+     * @returns true if both filterbanks are built for the same configuration
+     */
+    static bool matches(const mel_filterbank_t *a, const mel_filterbank_t *b) {
+        return a->type == b->type &&
+            a->version == b->version &&
+            a->sampling_frequency == b->sampling_frequency &&
+            a->low_frequency == b->low_frequency &&
+            a->high_frequency == b->high_frequency &&
+            a->fft_length == b->fft_length &&
+            a->num_filters == b->num_filters;
+    }
+
+    /**
+     * Calculate the memory needed by create()
+     * @param config Configuration part of a filterbank
+     * @param mem_size Out: size in bytes
+     * @returns EIDSP_OK if OK
+     */
+    static int get_mem_size(const mel_filterbank_t *config, size_t *mem_size) {
+        size_t weights_count = 0;
+        int ret = build(config, nullptr, nullptr, nullptr, &weights_count);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        *mem_size = weights_count * sizeof(float) + 2 * config->num_filters * sizeof(uint16_t);
+        return EIDSP_OK;
+    }
+
+    /**
+     * Compute the weights of a filterbank, only the non-zero span of every filter is stored
+     * @param filterbank Configuration filled in, the table pointers are set here
+     * @param mem Memory for the table, 4 byte aligned
+     * @param mem_size Size of mem, see get_mem_size()
+     * @returns EIDSP_OK if OK
+     */
+    static int create(mel_filterbank_t *filterbank, void *mem, size_t mem_size) {
+        size_t weights_count = 0;
+        int ret = build(filterbank, nullptr, nullptr, nullptr, &weights_count);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        if (weights_count * sizeof(float) + 2 * filterbank->num_filters * sizeof(uint16_t) > mem_size) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        float *weights = (float *)mem;
+        uint16_t *bin_start = (uint16_t *)(weights + weights_count);
+        uint16_t *bin_count = bin_start + filterbank->num_filters;
+
+        ret = build(filterbank, bin_start, bin_count, weights, &weights_count);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        filterbank->bin_start = bin_start;
+        filterbank->bin_count = bin_count;
+        filterbank->weights = weights;
+        return EIDSP_OK;
+    }
+
+    /**
+     * Mel energies of one power spectrum frame
+     * @param filterbank Filterbank from create() or a const table
+     * @param power_spectrum fft_length / 2 + 1 bins
+     * @param out num_filters energies
+     */
+    static void apply(const mel_filterbank_t *filterbank, const float *power_spectrum, float *out) {
+        const float *weights = filterbank->weights;
+
+        for (size_t ix = 0; ix < filterbank->num_filters; ix++) {
+            const float *bins = power_spectrum + filterbank->bin_start[ix];
+            const size_t count = filterbank->bin_count[ix];
+
+            float sum = 0.0f;
+            for (size_t bin = 0; bin < count; bin++) {
+                sum += bins[bin] * weights[bin];
+            }
+            out[ix] = sum;
+
+            weights += count;
+        }
+    }
+
+private:
+    /**
+     * FFT bin of the edges of every filter, i.e. num_filters + 2 bins. Same math
+     * as feature::filterbanks() and feature::mfe() (including their rounding quirks).
+     */
+    static int get_edges(const mel_filterbank_t *config, int *edges) {
+        const size_t edges_count = config->num_filters + 2;
+        const size_t mem_size = edges_count * sizeof(float);
+
+        float *mels = (float *)ei_dsp_calloc(edges_count, sizeof(float));
+        EI_ERR_AND_RETURN_ON_NULL(mels, EIDSP_OUT_OF_MEM);
+        ei_unique_ptr_t __ptr__(mels, [mem_size](void *ptr) { ei::ei_dsp_free_func(ptr, mem_size); });
+
+        numpy::linspace(
+            functions::frequency_to_mel(static_cast<float>(config->low_frequency)),
+            functions::frequency_to_mel(static_cast<float>(config->high_frequency)),
+            edges_count,
+            mels);
+
+        // mfe() in v4+ preserves a bug of v<4 by binning against fft_length
+        const uint16_t coefficients = config->fft_length / 2 + 1;
+        const uint16_t max_bin = (config->type == MEL_FILTERBANK_TRIANGLE && config->version >= 4) ?
+            config->fft_length : coefficients;
+
+        for (size_t ix = 0; ix < edges_count; ix++) {
+            float hertz = functions::mel_to_frequency(mels[ix]);
+            // mfe() never clamps the last edge to the low frequency
+            if (hertz < config->low_frequency &&
+                    (ix < edges_count - 1 || config->type == MEL_FILTERBANK_SPEECHPY)) {
+                hertz = config->low_frequency;
+            }
+            if (hertz > config->high_frequency) {
+                hertz = config->high_frequency;
+            }
+
+            // Speechpy calculates the last bucket from 7,999.999999 rather than 8,000 Hz
+            // (for a 16 kHz sampling rate), so 64 instead of 65, match that
+            if (ix == edges_count - 1) {
+                hertz -= 0.001;
+            }
+
+            edges[ix] = static_cast<int>(floor((max_bin + 1) * hertz / config->sampling_frequency));
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Dense weights of one filter over all power spectrum bins
+     */
+    static int get_filter(const mel_filterbank_t *config, const int *edges, size_t ix,
+        float *row, size_t row_size)
+    {
+        const int left = edges[ix];
+        const int middle = edges[ix + 1];
+        const int right = edges[ix + 2];
+
+        if (left < 0 || left > middle || middle > right || right >= (int)row_size) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        memset(row, 0, row_size * sizeof(float));
+
+        if (config->type == MEL_FILTERBANK_TRIANGLE) {
+            // both left and right are zero weights, middle always has weight 1.0
+            row[middle] = 1.0f;
+            for (int bin = left + 1; bin < right; bin++) {
+                if (bin < middle) {
+                    row[bin] = (static_cast<float>(bin) - left) / (middle - left);
+                }
+                if (bin > middle) {
+                    row[bin] = (right - static_cast<float>(bin)) / (right - middle);
+                }
+            }
+            return EIDSP_OK;
+        }
+
+        int ret = numpy::linspace(left, right, (right - left + 1), row + left);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+        ret = functions::triangle(row + left, (right - left + 1), left, middle, right);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+#if EIDSP_QUANTIZE_FILTERBANK
+        // same weights as the quantized dense filterbank
+        for (int bin = left; bin <= right; bin++) {
+            row[bin] = numpy::dequantize_zero_one(numpy::quantize_zero_one(row[bin]));
+        }
+#endif
+        return EIDSP_OK;
+    }
+
+    /**
+     * Count (all outputs nullptr but weights_count) or fill the sparse table
+     */
+    static int build(const mel_filterbank_t *config, uint16_t *bin_start, uint16_t *bin_count,
+        float *weights, size_t *weights_count)
+    {
+        if (config->num_filters == 0 || config->fft_length < 2 || config->sampling_frequency == 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        const size_t edges_size = (config->num_filters + 2) * sizeof(int);
+        int *edges = (int *)ei_dsp_malloc(edges_size);
+        EI_ERR_AND_RETURN_ON_NULL(edges, EIDSP_OUT_OF_MEM);
+        ei_unique_ptr_t __edges_ptr__(edges, [edges_size](void *ptr) { ei::ei_dsp_free_func(ptr, edges_size); });
+
+        int ret = get_edges(config, edges);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        const size_t row_size = config->fft_length / 2 + 1;
+        EI_DSP_MATRIX(row, 1, row_size);
+        if (!row.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        size_t count = 0;
+        for (size_t ix = 0; ix < config->num_filters; ix++) {
+            ret = get_filter(config, edges, ix, row.buffer, row_size);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+
+            // trim the zero weights on both sides
+            size_t first = 0;
+            size_t last = row_size;
+            while (first < row_size && row.buffer[first] == 0.0f) {
+                first++;
+            }
+            while (last > first && row.buffer[last - 1] == 0.0f) {
+                last--;
+            }
+            if (first == row_size) {
+                first = last = 0;
+            }
+
+            if (weights) {
+                bin_start[ix] = static_cast<uint16_t>(first);
+                bin_count[ix] = static_cast<uint16_t>(last - first);
+                memcpy(weights + count, row.buffer + first, (last - first) * sizeof(float));
+            }
+            count += last - first;
+        }
+
+        *weights_count = count;
+        return EIDSP_OK;
+    }
+};
+
+/**
+ * Sparse mel filterbanks of the MFE / MFCC blocks, so the weights are computed once per
+ * configuration rather than for every window (or slice). Lookups check the const tables
+ * first (EIDSP_MEL_FILTERBANK_CONST_TABLES), then tables built on first use in a static
+ * pool of EIDSP_MEL_FILTERBANK_CACHE_SIZE bytes, valid until clear(). With a size of 0 (the
+ * default) the pool isn't compiled in at all.
+ */
+class mel_filterbank_cache {
+public:
+    /**
+     * Filterbank for a configuration
+     * @param config Configuration part of a filterbank, see mel_filterbank::resolve_config()
+     * @returns the filterbank, or nullptr if it doesn't fit in the cache
+     */
+    static const mel_filterbank_t *get(const mel_filterbank_t *config) {
+#if EIDSP_MEL_FILTERBANK_CONST_TABLES == 1
+        for (size_t ix = 0; ix < ei_mel_filterbank_tables_size; ix++) {
+            if (mel_filterbank::matches(&ei_mel_filterbank_tables[ix], config)) {
+                return &ei_mel_filterbank_tables[ix];
+            }
+        }
+#endif // EIDSP_MEL_FILTERBANK_CONST_TABLES
+
+#if EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+        cache_t *cache = get_cache();
+
+        for (size_t ix = 0; ix < cache->table_count; ix++) {
+            if (mel_filterbank::matches(&cache->tables[ix], config)) {
+                return &cache->tables[ix];
+            }
+        }
+
+        if (cache->table_count >= EIDSP_MEL_FILTERBANK_CACHE_MAX_TABLES) {
+            return nullptr;
+        }
+
+        // keep the pool 8 byte aligned for the next table
+        size_t mem_size = 0;
+        if (mel_filterbank::get_mem_size(config, &mem_size) != EIDSP_OK) {
+            return nullptr;
+        }
+        mem_size = (mem_size + 7) & ~(size_t)7;
+        if (cache->used + mem_size > EIDSP_MEL_FILTERBANK_CACHE_SIZE) {
+            return nullptr;
+        }
+
+        mel_filterbank_t *table = &cache->tables[cache->table_count];
+        *table = *config;
+        if (mel_filterbank::create(table, (uint8_t *)cache->pool + cache->used, mem_size) != EIDSP_OK) {
+            return nullptr;
+        }
+
+        cache->used += mem_size;
+        cache->table_count++;
+        return table;
+#else
+        (void)config;
+        return nullptr;
+#endif // EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+    }
+
+    /**
+     * Drop all tables built at runtime, they're rebuilt on the next use
+     */
+    static void clear() {
+#if EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+        cache_t *cache = get_cache();
+        cache->table_count = 0;
+        cache->used = 0;
+#endif // EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+    }
+
+    /**
+     * @returns bytes of the pool in use
+     */
+    static size_t get_used_bytes() {
+#if EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+        return get_cache()->used;
+#else
+        return 0;
+#endif // EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+    }
+
+#if EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+private:
+    typedef struct {
+        mel_filterbank_t tables[EIDSP_MEL_FILTERBANK_CACHE_MAX_TABLES];
+        size_t table_count;
+        size_t used;
+        uint64_t pool[(EIDSP_MEL_FILTERBANK_CACHE_SIZE + 7) / 8];
+    } cache_t;
+
+    // one instance for the whole program
+    static cache_t *get_cache() {
+        static cache_t cache;
+        return &cache;
+    }
+#endif // EIDSP_MEL_FILTERBANK_CACHE_SIZE > 0
+};
+
+} // namespace speechpy
+} // namespace ei
+
+#endif // _EIDSP_SPEECHPY_MEL_FILTERBANK_H_
@@ -33,6 +33,7 @@
 
 #include "../config.hpp"
 #include "feature.hpp"
+#include "feature_q15.hpp"
 #include "functions.hpp"
 #include "processing.hpp"
 
@@ -40,6 +40,8 @@
 #include <cstdio>
 #include "unistd.h"
 #include "cyhal.h"
+#include "../../classifier/ei_inference_arena.h"
+#include "../../classifier/ei_op_profile.h"
 #ifdef FREERTOS_ENABLED
 #include <FreeRTOS.h>
 #include <timers.h>
@@ -56,6 +58,12 @@ static void systick_isr(void)
 }
 #endif
 
+/* DWT cycle counter extended to 64 bits, see ei_read_timer_us() */
+static bool cycle_counter_init = false;
+static uint32_t cycle_counter_last = 0;
+static uint32_t cycle_counter_last_ms = 0;
+static uint64_t cycle_counter = 0;
+
 __attribute__((weak)) EI_IMPULSE_ERROR ei_run_impulse_check_canceled() {
     return EI_IMPULSE_OK;
 }
@@ -72,10 +80,6 @@ __attribute__((weak)) uint64_t ei_read_timer_ms() {
     return xTaskGetTickCount();
 }
 
-__attribute__((weak)) uint64_t ei_read_timer_us() {
-
-    return xTaskGetTickCount()*1000;
-}
 #else /* Bare-metal */
 __attribute__((weak)) EI_IMPULSE_ERROR ei_sleep(int32_t time_ms) {
     cyhal_system_delay_ms(time_ms);
@@ -101,11 +105,65 @@ uint64_t ei_read_timer_ms() {
     return tick;
 }
 
-uint64_t ei_read_timer_us() {
-    return ei_read_timer_ms() * 1000;
-}
 #endif /* FREERTOS_ENABLED */
 
+/**
+ * @brief Microseconds from the DWT cycle counter. CYCCNT wraps every 2^32 cycles
+ * (~28 s at 150 MHz), wraps that happened between two calls are recovered from
+ * the millisecond tick, so the timer doesn't have to be read at least once per wrap.
+ * CYCCNT also stops while the CPU is in (tickless) deep sleep. If the ms tick moved
+ * on by more than a tick beyond what the cycles and whole wraps explain, the counter
+ * is rebased on the ms tick, so the us clock doesn't fall behind it.
+ */
+__attribute__((weak)) uint64_t ei_read_timer_us() {
+    uint32_t irq = cyhal_system_critical_section_enter();
+
+    if(cycle_counter_init == false) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        cycle_counter_last = 0;
+        cycle_counter_last_ms = (uint32_t)ei_read_timer_ms();
+        cycle_counter_init = true;
+    }
+
+    uint32_t now = DWT->CYCCNT;
+    uint32_t now_ms = (uint32_t)ei_read_timer_ms();
+    uint32_t delta = now - cycle_counter_last;
+    uint64_t cycles_per_ms = SystemCoreClock / 1000;
+    uint64_t expected = (uint64_t)(now_ms - cycle_counter_last_ms) * cycles_per_ms;
+    uint64_t elapsed = delta;
+
+    if(expected > delta) {
+        /* number of whole wraps the 32-bit delta is missing, rounded to absorb tick jitter */
+        elapsed += ((expected - delta + 0x80000000ULL) >> 32) << 32;
+
+        /* more than a tick off either way: CYCCNT was stopped, take the ms tick */
+        if(expected > elapsed + cycles_per_ms || elapsed > expected + cycles_per_ms) {
+            elapsed = expected;
+        }
+    }
+    cycle_counter += elapsed;
+    cycle_counter_last = now;
+    cycle_counter_last_ms = now_ms;
+
+    uint64_t cycles = cycle_counter;
+    cyhal_system_critical_section_exit(irq);
+
+    return cycles / (SystemCoreClock / 1000000);
+}
+
+/**
+ * @brief Raw DWT cycle counter for the per-op profile, callers only use differences
+ */
+uint32_t ei_op_profile_read_cycles(void) {
+    if(cycle_counter_init == false) {
+        (void)ei_read_timer_us();
+    }
+
+    return DWT->CYCCNT;
+}
+
 void ei_putchar(char c)
 {
     putchar(c);
@@ -131,16 +189,26 @@ __attribute__((weak)) void ei_printf_float(float f) {
     ei_printf("%f", f);
 }
 
+/* While an impulse runs, its scratch allocations come from the static inference arena
+ * and only go to the heap if the arena is full */
 #ifdef FREERTOS_ENABLED
+void *ei_inference_arena_owner(void) {
+    return xTaskGetCurrentTaskHandle();
+}
+
 __attribute__((weak)) void *ei_malloc(size_t size) {
-    return pvPortMalloc(size);
+    void *mem = ei_inference_arena_try_malloc(size);
+
+    return mem ? mem : pvPortMalloc(size);
 }
 
 __attribute__((weak)) void *ei_calloc(size_t nitems, size_t size) {
-    void *mem = NULL;
+    void *mem = ei_inference_arena_try_malloc(nitems * size);
 
-    /* Infineon port of FreeRTOS does not support pvPortCalloc */
-    mem = pvPortMalloc(nitems * size);
+    if (mem == NULL) {
+        /* Infineon port of FreeRTOS does not support pvPortCalloc */
+        mem = pvPortMalloc(nitems * size);
+    }
     if (mem) {
         /* zero the memory */
         memset(mem, 0, nitems * size);
@@ -149,19 +217,31 @@ __attribute__((weak)) void *ei_calloc(size_t nitems, size_t size) {
 }
 
 __attribute__((weak)) void ei_free(void *ptr) {
-    vPortFree(ptr);
+    if (!ei_inference_arena_free(ptr)) {
+        vPortFree(ptr);
+    }
 }
 #else
 __attribute__((weak)) void *ei_malloc(size_t size) {
-    return malloc(size);
+    void *mem = ei_inference_arena_try_malloc(size);
+
+    return mem ? mem : malloc(size);
 }
 
 __attribute__((weak)) void *ei_calloc(size_t nitems, size_t size) {
+    void *mem = ei_inference_arena_try_malloc(nitems * size);
+
+    if (mem) {
+        memset(mem, 0, nitems * size);
+        return mem;
+    }
     return calloc(nitems, size);
 }
 
 __attribute__((weak)) void ei_free(void *ptr) {
-    free(ptr);
+    if (!ei_inference_arena_free(ptr)) {
+        free(ptr);
+    }
 }
 #endif
 
@@ -36,6 +36,7 @@
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/classifier/ei_op_profile.h"
 
 #if EI_CLASSIFIER_PRINT_STATE
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
@@ -574,6 +575,10 @@ TfLiteStatus tflite_learn_43_3_init( void*(*alloc_fnc)(size_t,size_t) ) {
 
   registrations[OP_FULLY_CONNECTED] = Register_FULLY_CONNECTED();
   registrations[OP_SOFTMAX] = Register_SOFTMAX();
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+  registrations[OP_FULLY_CONNECTED].builtin_code = BuiltinOperator_FULLY_CONNECTED;
+  registrations[OP_SOFTMAX].builtin_code = BuiltinOperator_SOFTMAX;
+#endif
 
   for (size_t g = 0; g < 1; ++g) {
     current_subgraph_index = g;
@@ -616,7 +621,11 @@ TfLiteStatus tflite_learn_43_3_invoke() {
   for (size_t i = 0; i < 4; ++i) {
     ResetTensors();
 
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    TfLiteStatus status = ei_op_profile_invoke(&ctx, &tflNodes[i], &registrations[used_ops[i]], i);
+#else
     TfLiteStatus status = registrations[used_ops[i]].invoke(&ctx, &tflNodes[i]);
+#endif
 
 #if EI_CLASSIFIER_PRINT_STATE
     ei_printf("layer %lu\n", i);
@@ -74,6 +74,9 @@
 #define AT_READBUFFER                "READBUFFER"
 #define AT_READBUFFER_ARGS           "START,LENGTH,[USEMAXRATE]"
 #define AT_READBUFFER_HELP_TEXT      "Read from the temporary buffer (as base64)"
+#define AT_READBUFFERBIN             "READBUFFERBIN"
+#define AT_READBUFFERBIN_ARGS        "START,LENGTH,[USEMAXRATE],[WINDOW]"
+#define AT_READBUFFERBIN_HELP_TEXT   "Read from the temporary buffer (as CRC32 checked binary frames)"
 #define AT_UNLINKFILE                "UNLINKFILE"
 #define AT_UNLINKFILE_ARGS           "FILE"
 #define AT_UNLINKFILE_HELP_TEXT      "Unlink a specific file"
@@ -126,6 +129,13 @@
 #define AT_BOOTMODE_HELP_TEXT       "Jump to bootloader"
 #define AT_INFO                     "INFO"
 #define AT_INFO_HELP_TEXT           "Prints details about compiled firmware and ML model"
+#define AT_SAMPLECLOCK              "SAMPLECLOCK"
+#define AT_SAMPLECLOCK_HELP_TEXT    "Print sample clock statistics of the last sampling"
+#define AT_RUNIMPULSESCHED          "RUNIMPULSESCHED"
+#define AT_RUNIMPULSESCHED_ARGS     "PERIOD_MS,WINDOW_MS"
+#define AT_RUNIMPULSESCHED_HELP_TEXT "Run the impulse on a window every period, sleep in between"
+#define AT_OPPROFILE                "OPPROFILE"
+#define AT_OPPROFILE_HELP_TEXT      "Print (?) or clear the per-op model profile"
 
 /*************************************************************************************************/
 /* HELP is not necessary as it is built-in into ATServer and
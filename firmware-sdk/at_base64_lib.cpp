@@ -228,6 +228,48 @@ int base64_encode_buffer(const char *input, size_t input_size, char *output, siz
     return output_ix;
 }
 
+/**
+ * @brief Base64 encode a block into output buffer, 3 input bytes at a time straight
+ * through the alphabet table. Output must hold ((input_size + 2) / 3) * 4 bytes.
+ * Only the last block of a stream may have input_size not divisible by 3.
+ *
+ * @param input
+ * @param input_size
+ * @param output
+ * @return size_t number of bytes written to output
+ */
+size_t base64_encode_block(const uint8_t *input, size_t input_size, char *output)
+{
+    char *out = output;
+
+    while (input_size >= 3) {
+        uint32_t triple = ((uint32_t)input[0] << 16) | ((uint32_t)input[1] << 8) | input[2];
+
+        out[0] = base64_chars[(triple >> 18) & 0x3f];
+        out[1] = base64_chars[(triple >> 12) & 0x3f];
+        out[2] = base64_chars[(triple >> 6) & 0x3f];
+        out[3] = base64_chars[triple & 0x3f];
+        out += 4;
+        input += 3;
+        input_size -= 3;
+    }
+
+    if (input_size) {
+        uint32_t triple = (uint32_t)input[0] << 16;
+        if (input_size == 2) {
+            triple |= (uint32_t)input[1] << 8;
+        }
+
+        out[0] = base64_chars[(triple >> 18) & 0x3f];
+        out[1] = base64_chars[(triple >> 12) & 0x3f];
+        out[2] = (input_size == 2) ? base64_chars[(triple >> 6) & 0x3f] : '=';
+        out[3] = '=';
+        out += 4;
+    }
+
+    return out - output;
+}
+
 std::vector<unsigned char> base64_decode(std::string const& encoded_string) {
   int in_len = encoded_string.size();
   int i = 0;
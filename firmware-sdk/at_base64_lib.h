@@ -62,6 +62,7 @@
 
 */
 
+#include <cstdint>
 #include <cstdlib>
 #include <string>
 #include <vector>
@@ -71,6 +72,7 @@ void base64_encode(const char *input, size_t input_size, void (*putc_f)(char));
 void base64_encode_chunk(const char *input, size_t input_size, void (*putc_f)(char));
 void base64_encode_finish(void (*putc_f)(char));
 int base64_encode_buffer(const char *input, size_t input_size, char *output, size_t output_size);
+size_t base64_encode_block(const uint8_t *input, size_t input_size, char *output);
 std::vector<unsigned char> base64_decode(std::string const&);
 
 #endif /* EI_AT_BASE64_LIB_H */
@@ -488,6 +488,15 @@ public:
         return false;
     }
 
+    /**
+     * @brief Time of the sample tick the sample callback is running for, in us.
+     * Devices with a sample clock return the tick time instead of the time the callback got to run.
+     */
+    virtual uint64_t get_sample_timestamp_us(void)
+    {
+        return ei_read_timer_us();
+    }
+
 #if MULTI_FREQ_ENABLED == 1
 	uint32_t actual_timer;
     std::vector<float> multi_sample_interval;
@@ -108,6 +108,152 @@ __attribute__((weak)) bool read_encode_send_sample_buffer(size_t address, size_t
     return true;
 }
 
+#define FRAME_MAGIC_SIZE    2
+#define FRAME_HEADER_SIZE   (FRAME_MAGIC_SIZE + 2 + 4 + 2)
+#define FRAME_PAYLOAD_SIZE  512
+#define FRAME_CRC_SIZE      4
+#define FRAME_ACK           0x06
+#define FRAME_NAK           0x15
+#define FRAME_ACK_TIMEOUT_MS 1000
+
+/**
+ * @brief CRC32 (IEEE 802.3, reflected), same as zlib/binascii crc32.
+ * Start with crc = 0, pass the result back in to continue.
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+    static const uint32_t nibble_table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    crc = ~crc;
+    while (length--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ nibble_table[crc & 0x0f];
+        crc = (crc >> 4) ^ nibble_table[crc & 0x0f];
+    }
+
+    return ~crc;
+}
+
+static inline void put_u16_le(uint8_t *buf, uint16_t value)
+{
+    buf[0] = value & 0xff;
+    buf[1] = (value >> 8) & 0xff;
+}
+
+static inline void put_u32_le(uint8_t *buf, uint32_t value)
+{
+    put_u16_le(buf, value & 0xffff);
+    put_u16_le(buf + 2, value >> 16);
+}
+
+/**
+ * @brief Default raw output, byte by byte. Only binary safe if ei_putchar doesn't
+ * translate line endings, targets with a CRLF converting stdout override this.
+ */
+__attribute__((weak)) void ei_write_raw(const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        ei_putchar(data[i]);
+    }
+}
+
+/**
+ * @brief Wait for an ACK/NAK from the host
+ *
+ * @return FRAME_ACK, FRAME_NAK or 0 on timeout
+ */
+static uint8_t frame_wait_ack(void)
+{
+    uint64_t start_time = ei_read_timer_ms();
+
+    while (ei_read_timer_ms() - start_time < FRAME_ACK_TIMEOUT_MS) {
+        uint8_t rec = ei_getchar();
+        if (rec == FRAME_ACK || rec == FRAME_NAK) {
+            return rec;
+        }
+    }
+
+    return 0;
+}
+
+__attribute__((weak)) bool read_send_sample_buffer_framed(size_t address, size_t length, uint32_t window)
+{
+    EiDeviceInfo *dev = EiDeviceInfo::get_device();
+    EiDeviceMemory *memory = dev->get_memory();
+    // one frame is built while the other one may still be going out
+    static uint8_t frames[2][FRAME_HEADER_SIZE + FRAME_PAYLOAD_SIZE + FRAME_CRC_SIZE];
+    uint8_t frame_ix = 0;
+    bool ret = true;
+    size_t sent = 0;
+    uint16_t seq = 0;
+    // first frame of the current ACK window, resent on NAK
+    size_t window_sent = 0;
+    uint16_t window_seq = 0;
+    uint32_t window_frames = 0;
+
+    while (1) {
+        uint8_t *frame = frames[frame_ix];
+        size_t payload_size = length - sent;
+
+        if (payload_size > FRAME_PAYLOAD_SIZE) {
+            payload_size = FRAME_PAYLOAD_SIZE;
+        }
+
+        frame[0] = 'E';
+        frame[1] = 'I';
+        put_u16_le(&frame[2], seq);
+        put_u32_le(&frame[4], address + sent);
+        put_u16_le(&frame[8], payload_size);
+
+        if (payload_size > 0 &&
+            memory->read_sample_data(&frame[FRAME_HEADER_SIZE], address + sent, payload_size) != payload_size) {
+            ret = false;
+            break;
+        }
+
+        uint32_t crc = crc32_update(0, &frame[FRAME_MAGIC_SIZE], FRAME_HEADER_SIZE - FRAME_MAGIC_SIZE + payload_size);
+        put_u32_le(&frame[FRAME_HEADER_SIZE + payload_size], crc);
+
+        ei_write_raw(frame, FRAME_HEADER_SIZE + payload_size + FRAME_CRC_SIZE);
+        frame_ix ^= 1;
+
+        sent += payload_size;
+        seq++;
+        window_frames++;
+
+        if (window > 0 && (window_frames == window || payload_size == 0)) {
+            uint8_t ack = frame_wait_ack();
+
+            if (ack == FRAME_NAK) {
+                sent = window_sent;
+                seq = window_seq;
+                window_frames = 0;
+                continue;
+            }
+            else if (ack != FRAME_ACK) {
+                ret = false;
+                break;
+            }
+
+            window_sent = sent;
+            window_seq = seq;
+            window_frames = 0;
+        }
+
+        if (payload_size == 0) {
+            break;
+        }
+    }
+
+    // wait for the last frame to go out before anything else is printed
+    ei_write_raw(NULL, 0);
+
+    return ret;
+}
+
 bool run_impulse_static_data(bool debug, size_t length, size_t buf_len)
 {
     size_t cur_pos = 0;
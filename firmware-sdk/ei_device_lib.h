@@ -58,6 +58,37 @@ bool ei_user_invoke_stop_lib(void);
  */
 bool read_encode_send_sample_buffer(size_t address, size_t length);
 
+/**
+ * @brief Helper function for sending data from memory over the serial
+ * port as binary frames:
+ *   'E' 'I' | seq (u16) | offset (u32) | length (u16) | payload | crc32 (u32)
+ * Integers are little-endian, offset is the absolute address of the payload,
+ * CRC32 (IEEE) covers everything after the magic. A frame with length 0 ends
+ * the transfer. An interrupted transfer is resumed by requesting the data from
+ * the offset of the first bad frame.
+ *
+ * @param address address of samples
+ * @param length number of samples (bytes)
+ * @param window if not 0, wait for an ACK (0x06) after every window frames;
+ *               a NAK (0x15) makes the device resend the whole window
+ * @return true if everything went fine
+ * @return false if samples read failed or an ACK didn't come in time
+ */
+bool read_send_sample_buffer_framed(size_t address, size_t length, uint32_t window);
+
+/**
+ * @brief Send raw bytes over the serial port, without any line ending
+ * translation. May return before the bytes are out, in that case data has to
+ * stay untouched until the next call, which waits for the previous transfer.
+ * ei_write_raw(NULL, 0) only waits until everything is sent.
+ *
+ * @param data bytes to send
+ * @param length number of bytes
+ */
+void ei_write_raw(const uint8_t *data, size_t length);
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length);
+
 bool run_impulse_static_data(bool debug, size_t length, size_t buf_len);
 
 EI_IMPULSE_ERROR ei_start_impulse_static_data(bool debug, float* data, size_t size);
@@ -91,6 +91,86 @@ protected:
      *
      */
     uint32_t memory_size;
+    /**
+     * @brief optional write-back cache for a single program page, see enable_page_cache()
+     *
+     */
+    uint8_t *page_cache;
+    uint32_t page_cache_size;
+    uint32_t page_cache_address;
+    uint32_t page_cache_fill;
+
+    /**
+     * @brief Collect sample writes into full program pages before passing them to write_data().
+     * Useful for memories where every write call has a large fixed cost (e.g. QSPI NOR Flash
+     * command overhead) and the samplers are writing small chunks of data.
+     *
+     * @param buffer buffer of at least size bytes, owned by the derived class
+     * @param size program page size of the memory in bytes
+     */
+    void enable_page_cache(uint8_t *buffer, uint32_t size)
+    {
+        page_cache = buffer;
+        page_cache_size = size;
+        page_cache_address = 0;
+        page_cache_fill = 0;
+    }
+
+    /**
+     * @brief Write sample data through the page cache. Contiguous writes are merged,
+     * the page is written out when full or when a non-contiguous write arrives.
+     * Whole aligned pages bypass the cache.
+     */
+    uint32_t write_cached(const uint8_t *data, uint32_t address, uint32_t num_bytes)
+    {
+        uint32_t written = 0;
+
+        while (num_bytes > 0) {
+            // non-contiguous write, write out what we have collected so far
+            if (page_cache_fill != 0 && address != page_cache_address + page_cache_fill) {
+                uint32_t pending = page_cache_fill;
+                if (flush_data() != pending) {
+                    break;
+                }
+            }
+
+            uint32_t page_offset = address % page_cache_size;
+            uint32_t chunk = page_cache_size - page_offset;
+
+            if (page_cache_fill == 0 && page_offset == 0 && num_bytes >= page_cache_size) {
+                // nothing pending and page aligned, write all whole pages directly
+                chunk = num_bytes - (num_bytes % page_cache_size);
+                if (write_data(data, address, chunk) != chunk) {
+                    break;
+                }
+            }
+            else {
+                if (chunk > num_bytes) {
+                    chunk = num_bytes;
+                }
+                if (page_cache_fill == 0) {
+                    page_cache_address = address;
+                }
+                memcpy(&page_cache[page_cache_fill], data, chunk);
+                page_cache_fill += chunk;
+
+                // reached the end of the page
+                if (page_offset + chunk == page_cache_size) {
+                    uint32_t pending = page_cache_fill;
+                    if (flush_data() != pending) {
+                        break;
+                    }
+                }
+            }
+
+            data += chunk;
+            address += chunk;
+            num_bytes -= chunk;
+            written += chunk;
+        }
+
+        return written;
+    }
 
 public:
     /**
@@ -124,6 +204,11 @@ public:
         , block_size(block_size)
         , block_erase_time(erase_time)
     {
+        page_cache = nullptr;
+        page_cache_size = 0;
+        page_cache_address = 0;
+        page_cache_fill = 0;
+
         if(config_size == 0) {
             // this means we are not storing the config
             used_blocks = 0;
@@ -184,6 +269,11 @@ public:
     {
         uint32_t offset = used_blocks * block_size;
 
+        // make sure we are not reading stale data from the memory
+        if (page_cache_fill != 0) {
+            flush_data();
+        }
+
         return read_data(sample_data, offset + address, sample_data_size);
     }
 
@@ -192,6 +282,10 @@ public:
     {
         uint32_t offset = used_blocks * block_size;
 
+        if (page_cache != nullptr) {
+            return write_cached(sample_data, offset + address, sample_data_size);
+        }
+
         return write_data(sample_data, offset + address, sample_data_size);
     }
 
@@ -199,18 +293,47 @@ public:
     {
         uint32_t offset = used_blocks * block_size;
 
+        // keep the write order, pending page goes first
+        if (page_cache_fill != 0) {
+            flush_data();
+        }
+
         return erase_data(offset + address, num_bytes);
     }
 
 
+    /**
+     * @brief Erase sample region before sampling. The default implementation erases the whole
+     * region before returning. Memories that can erase in the background may erase only
+     * the beginning of the region and keep erasing ahead of the sample writes.
+     *
+     * @param address address in the sample memory where the erase should begin, block aligned
+     * @param num_bytes number of bytes that will be used for samples
+     * @return uint32_t number of bytes erased or scheduled for erase, if differs from num_bytes, then some error occurred.
+     */
+    virtual uint32_t erase_sample_data_ahead(uint32_t address, uint32_t num_bytes)
+    {
+        return erase_sample_data(address, num_bytes);
+    }
+
     /**
      * @brief Necessary for targets, such as RP2040, which have large Flash page size (256 bytes)
      * For the targets, that doesn't require it, a default dummy implementation is provided
      * to reduce boilerplate code in the target flash implementation file.
+     * If the page cache is enabled (see enable_page_cache()), the pending page is written out.
+     *
+     * @return uint32_t number of bytes written, 0 if nothing was pending or write failed
      */
     virtual uint32_t flush_data(void)
     {
-        return 0;
+        if (page_cache == nullptr || page_cache_fill == 0) {
+            return 0;
+        }
+
+        uint32_t written = write_data(page_cache, page_cache_address, page_cache_fill);
+        page_cache_fill = 0;
+
+        return written;
     }
 
     /**
@@ -223,12 +346,12 @@ public:
     }
 
     /**
-     * @brief 
-     * 
+     * @brief Called when sampling is finished, writes out any data still held in the page cache
+     *
      */
     virtual void finalize_samplig(void)
     {
-        
+        flush_data();
     }
 };
 
@@ -67,6 +67,18 @@ vector<fused_sensors_t> fused_sensors;
 */
 static vector<ei_device_fusion_sensor_t *> fusion_sensors;
 int num_fusions, num_fusion_axis;
+/*
+** @brief gather plan, built by ei_connect_fusion_list so sampling doesn't touch the heap
+** fusion_gather_axis[n] is the sensor axis copied to slot n of the fused frame,
+** fusion_gather_count[i] the number of slots filled by fusion_sensors[i]
+*/
+static uint8_t fusion_gather_axis[EI_MAX_SENSOR_AXES];
+static uint8_t fusion_gather_count[NUM_MAX_FUSIONS];
+static fusion_sample_format_t fusion_frame[EI_MAX_SENSOR_AXES];
+/*
+** @brief sample tick time of the fused frame being read, for the sensors' read_data
+*/
+static uint64_t fusion_sample_timestamp_us;
 #if MULTI_FREQ_ENABLED == 1
 #define MULTI_FREQ_MAX_FREQ_NOT_SET     (-1.0f)
 
@@ -76,7 +88,7 @@ int num_fusions, num_fusion_axis;
 
 static float multi_sampling_freq[NUM_MAX_FUSIONS];
 static float multi_freq_combination[NUM_MAX_FUSIONS][EI_MAX_FREQUENCIES];
-static fusion_sample_format_t* old_data;    // store old samples for multi
+static fusion_sample_format_t old_data[EI_MAX_SENSOR_AXES];    // store old samples for multi
 #endif
 
 /* Private function prototypes --------------------------------------------- */
@@ -92,6 +104,7 @@ static int generate_bit_flags(int dec);
 static bool add_sensor(int sensor_ix, char *name_buffer);
 static bool add_axis(int sensor_ix, char *name_buffer);
 static float highest_frequency(float *frequencies, size_t size);
+static bool build_gather_plan(void);
 #if MULTI_FREQ_ENABLED == 1
 static float calc_gcd(float time1, float time2);
 static void get_multi_freq_combinations(int row, int col, float* mat_period, float* actual_comb, int ix, vector<float>* freq_comb, vector<int>* mem_fact, float allowed_period);
@@ -171,9 +184,31 @@ bool ei_connect_fusion_list(const char *input_list, ei_fusion_list_format format
 
     ei_free(input_string);
 
+    if (is_fusion) {
+        is_fusion = build_gather_plan();
+    }
+
     return is_fusion;
 }
 
+/**
+ * @brief Check if a sensor has axes in the list connected by ei_connect_fusion_list
+ *
+ * @param[in]  read_data  read function of the sensor, identifies it
+ *
+ * @retval  true if the sensor is sampled
+ */
+bool ei_fusion_is_sensor_connected(fusion_sample_format_t *(*read_data)(int n_samples))
+{
+    for (int i = 0; i < num_fusions; i++) {
+        if (fusion_sensors[i]->read_data == read_data && fusion_gather_count[i] > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /**
  * @brief Get sensor data and extract needed sensors
  * Callback function writes data to mem
@@ -182,13 +217,9 @@ void ei_fusion_read_axis_data(void)
 {
     EiDeviceInfo* dev = EiDeviceInfo::get_device();
     fusion_sample_format_t *sensor_data;
-    fusion_sample_format_t *data;
     uint32_t loc = 0;
 
-    data = (fusion_sample_format_t *)ei_malloc(sizeof(fusion_sample_format_t) * num_fusion_axis);
-    if (data == NULL) {
-        return;
-    }
+    fusion_sample_timestamp_us = dev->get_sample_timestamp_us();
 
     for (int i = 0; i < num_fusions; i++) {
 
@@ -198,28 +229,25 @@ void ei_fusion_read_axis_data(void)
                 fusion_sensors[i]->num_axis); // read sensor data from sensor file
         }
 
-        if (sensor_data != NULL) {
-            for (int j = 0; j < fusion_sensors[i]->num_axis; j++) {
-                if (fusion_sensors[i]->axis_flag_used & (1 << j)) {
-                    data[loc++] = *(sensor_data + j); // add sensor data to fusion data
-                }
-            }
-        }
-        else { // No data, zero fill
-            for (int j = 0; j < fusion_sensors[i]->num_axis; j++) {
-                if (fusion_sensors[i]->axis_flag_used & (1 << j)) {
-                    data[loc++] = 0;
-                }
-            }
+        for (int j = 0; j < fusion_gather_count[i]; j++, loc++) {
+            // add sensor data to fusion data, no data: zero fill
+            fusion_frame[loc] = (sensor_data != NULL) ? sensor_data[fusion_gather_axis[loc]] : 0;
         }
     }
 
     if (fusion_cb_sampler(
-            (const void *)&data[0],
+            (const void *)&fusion_frame[0],
             (sizeof(fusion_sample_format_t) * num_fusion_axis))) // send fusion data to sampler
         dev->stop_sample_thread(); // if last sample detach
+}
 
-    ei_free(data);
+/**
+ * @brief Sample tick time (us) of the fused frame that is being read,
+ *        valid in the read_data function of a sensor
+ */
+uint64_t ei_fusion_get_sample_timestamp_us(void)
+{
+    return fusion_sample_timestamp_us;
 }
 
 #if MULTI_FREQ_ENABLED == 1
@@ -231,15 +259,11 @@ void ei_fusion_multi_read_axis_data(uint8_t flag_read)
 {
    EiDeviceInfo* dev = EiDeviceInfo::get_device();
    fusion_sample_format_t *sensor_data;
-   fusion_sample_format_t *data;
    uint32_t loc = 0;
 
-   if (flag_read != 0) {
-       data = (fusion_sample_format_t *)ei_malloc(sizeof(fusion_sample_format_t) * num_fusion_axis);
-       if (data == NULL) {
-           return;
-       }
+   fusion_sample_timestamp_us = dev->get_sample_timestamp_us();
 
+   if (flag_read != 0) {
        for (int i = 0; i < num_fusions; i++) {
 
            sensor_data = NULL;
@@ -249,40 +273,26 @@ void ei_fusion_multi_read_axis_data(uint8_t flag_read)
                    fusion_sensors[i]->num_axis); // read sensor data from sensor file
            }
 
-           if (sensor_data != NULL) {
-               for (int j = 0; j < fusion_sensors[i]->num_axis; j++, loc++) {
-                   if (fusion_sensors[i]->axis_flag_used & (1 << j)) {
-                       data[loc] = *(sensor_data + j); // add sensor data to fusion data
-                       if (old_data != nullptr) {
-
-                        old_data[loc] = data[loc];       // store in old structure
-                        }
-                   }
+           for (int j = 0; j < fusion_gather_count[i]; j++, loc++) {
+               if (sensor_data != NULL) {
+                   fusion_frame[loc] = sensor_data[fusion_gather_axis[loc]]; // add sensor data to fusion data
+                   old_data[loc] = fusion_frame[loc];       // store in old structure
                }
-           }
-           else { // No data, zero fill
-               for (int j = 0; j < fusion_sensors[i]->num_axis; j++, loc++) {
-                   if (fusion_sensors[i]->axis_flag_used & (1 << j)) {
-                       data[loc] = old_data[loc];       // not sampled, use last value
-                   }
+               else {
+                   fusion_frame[loc] = old_data[loc];       // not sampled, use last value
                }
            }
        }
 
        if (fusion_cb_sampler(
-               (const void *)&data[0],
+               (const void *)&fusion_frame[0],
                (sizeof(fusion_sample_format_t) * num_fusion_axis))) {
            dev->stop_sample_thread(); // if last sample detach
-           ei_free(old_data);
-           // send fusion data to sampler
        }
-
-       ei_free(data);
    }
    else {
        if (fusion_cb_sampler(nullptr, 0)) {
            dev->stop_sample_thread(); // if last sample detach
-           ei_free(old_data);
        }
    }
 
@@ -408,8 +418,7 @@ bool ei_fusion_setup_data_sampling(void)
     bool ret = false;
 
 #if MULTI_FREQ_ENABLED == 1
-    old_data = (fusion_sample_format_t *)ei_malloc(sizeof(fusion_sample_format_t) * num_fusion_axis);
-    memset(old_data, 0, sizeof(fusion_sample_format_t) * num_fusion_axis);
+    memset(old_data, 0, sizeof(old_data));
 
     if (num_fusions == 1) {
         ret = ei_sampler_start_sampling(
@@ -424,10 +433,6 @@ bool ei_fusion_setup_data_sampling(void)
                 (sizeof(fusion_sample_format_t) * num_fusion_axis));
     }
 
-    if (ret == false) {
-        ei_free(old_data);  //
-    }
-
 #else
     ret = ei_sampler_start_sampling(
             &payload,
@@ -700,6 +705,33 @@ static bool add_sensor(int sensor_ix, char *name_buffer)
     return is_fusion;
 }
 
+/**
+ * @brief      Build the gather plan for the connected sensors, mapping each slot of the
+ *             fused frame to a sensor axis (in the order axes are read in)
+ * @return     false if the fused frame doesn't fit EI_MAX_SENSOR_AXES
+ */
+static bool build_gather_plan(void)
+{
+    int loc = 0;
+
+    for (int i = 0; i < num_fusions; i++) {
+        fusion_gather_count[i] = 0;
+
+        for (int j = 0; j < fusion_sensors[i]->num_axis; j++) {
+            if (fusion_sensors[i]->axis_flag_used & (1 << j)) {
+                if (loc >= EI_MAX_SENSOR_AXES) {
+                    ei_printf("ERR: too many axes to fuse (max %d)\n", EI_MAX_SENSOR_AXES);
+                    return false;
+                }
+                fusion_gather_axis[loc++] = (uint8_t)j;
+                fusion_gather_count[i]++;
+            }
+        }
+    }
+
+    return true;
+}
+
 /**
  * @brief      Run through all axes names from sensor and compare with name_buffer
  *             It found add sensor to fusable_sensor_list[] array and set a axis flag
@@ -110,7 +110,9 @@ void ei_built_sensor_fusion_list(void);
 const std::vector<fused_sensors_t> &ei_get_sensor_fusion_list(void);
 
 bool ei_connect_fusion_list(const char *input_list, ei_fusion_list_format format);
+bool ei_fusion_is_sensor_connected(fusion_sample_format_t *(*read_data)(int n_samples));
 void ei_fusion_read_axis_data(void);
+uint64_t ei_fusion_get_sample_timestamp_us(void);
 bool ei_fusion_sample_start(sampler_callback callsampler, float sample_interval_ms);
 bool ei_fusion_setup_data_sampling(void);
 #if MULTI_FREQ_ENABLED == 1
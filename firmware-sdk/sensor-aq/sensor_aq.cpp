@@ -39,6 +39,9 @@
 //#include "qcbor.h"
 //#include "setup.h"
 #include "sensor_aq.h"
+extern "C" {
+#include "../QCBOR/src/ieee754.h"
+}
 
 
 extern void ei_printf(const char *format, ...);
@@ -132,9 +135,30 @@ static int sensor_aq_flush_buffer(sensor_aq_ctx *ctx) {
     // re-initialize
     QCBOREncode_Init(&ctx->encode_context, ctx->cbor_buffer);
 
+    ctx->pending_frames = 0;
+
     return AQ_OK;
 }
 
+/**
+ * Encode a float as float16 or float32, without the detour through double
+ * that QCBOREncode_AddDouble takes (no double precision FPU on most targets)
+ */
+static void sensor_aq_encode_float(QCBOREncodeContext *encode_context, float value, sensor_aq_float_encoding encoding) {
+    IEEE754_union encoded = IEEE754_FloatToSmallest(value);
+
+    if (encoding == AQ_FLOAT_HALF && encoded.uSize == IEEE754_UNION_IS_SINGLE) {
+        // unbiased exponent, only normal float16 numbers are accepted, rest stays float32
+        int32_t exponent = (int32_t)((encoded.uValue >> 23) & 0xff) - 127;
+        if (exponent >= -14 && exponent <= 15) {
+            encoded.uSize = IEEE754_UNION_IS_HALF;
+            encoded.uValue = IEEE754_FloatToHalf(value);
+        }
+    }
+
+    QCBOREncode_AddType7(encode_context, encoded.uSize, encoded.uValue);
+}
+
 /**
  * Initialize a sensor acquisition context
  *
@@ -207,6 +231,7 @@ int sensor_aq_init(sensor_aq_ctx *ctx, sensor_aq_payload_info *payload_info, EI_
     //int ctx_err;
 
     ctx->axis_count = 0;
+    ctx->pending_frames = 0;
 
     QCBOREncode_Init(&ctx->encode_context, ctx->cbor_buffer);
     QCBOREncode_OpenMap(&ctx->encode_context);
@@ -345,6 +370,12 @@ int sensor_aq_add_data(sensor_aq_ctx *ctx, float values[], size_t values_size) {
         return AQ_STREAM_IS_NULL;
     }
 
+    // frames from sensor_aq_add_data_compact() still live in the buffer
+    int fr = sensor_aq_flush(ctx);
+    if (fr != AQ_OK) {
+        return fr;
+    }
+
     // clear memory
     memset(ctx->cbor_buffer.ptr, 0, ctx->cbor_buffer.len);
 
@@ -384,6 +415,12 @@ int sensor_aq_add_data_i16(sensor_aq_ctx *ctx, int16_t values[], size_t values_s
         return AQ_STREAM_IS_NULL;
     }
 
+    // frames from sensor_aq_add_data_compact() still live in the buffer
+    int fr = sensor_aq_flush(ctx);
+    if (fr != AQ_OK) {
+        return fr;
+    }
+
     // clear memory
     memset(ctx->cbor_buffer.ptr, 0, ctx->cbor_buffer.len);
 
@@ -447,6 +484,12 @@ int sensor_aq_add_data_batch(sensor_aq_ctx *ctx, int16_t values[], size_t values
         return AQ_STREAM_IS_NULL;
     }
 
+    // frames from sensor_aq_add_data_compact() still live in the buffer
+    int fr = sensor_aq_flush(ctx);
+    if (fr != AQ_OK) {
+        return fr;
+    }
+
     // clear memory
     memset(ctx->cbor_buffer.ptr, 0, ctx->cbor_buffer.len);
 
@@ -468,6 +511,161 @@ int sensor_aq_add_data_batch(sensor_aq_ctx *ctx, int16_t values[], size_t values
     return sensor_aq_flush_buffer(ctx);
 }
 
+/**
+ * Start a new CBOR buffer if nothing is pending, or write out the pending frames
+ * when another frame of values_size values might not fit anymore
+ */
+static int sensor_aq_reserve_frame(sensor_aq_ctx *ctx, size_t values_size) {
+    // worst case: array header + float32 (5 bytes) per value
+    size_t max_frame_size = 3 + (values_size * 5);
+
+    if (ctx->pending_frames == 0) {
+        QCBOREncode_Init(&ctx->encode_context, ctx->cbor_buffer);
+    }
+    else if (UsefulOutBuf_GetEndPosition(&ctx->encode_context.OutBuf) + max_frame_size > ctx->cbor_buffer.len) {
+        return sensor_aq_flush_buffer(ctx);
+    }
+
+    return AQ_OK;
+}
+
+static int sensor_aq_encode_frame(sensor_aq_ctx *ctx, const float *values, size_t values_size, sensor_aq_float_encoding encoding) {
+    int fr = sensor_aq_reserve_frame(ctx, values_size);
+    if (fr != AQ_OK) {
+        return fr;
+    }
+
+    // If we only have a single axis then emit flattened array (saves space)
+    if (values_size == 1) {
+        sensor_aq_encode_float(&ctx->encode_context, values[0], encoding);
+    }
+    else {
+        QCBOREncode_OpenArray(&ctx->encode_context);
+
+        for (size_t ix = 0; ix < values_size; ix++) {
+            sensor_aq_encode_float(&ctx->encode_context, values[ix], encoding);
+        }
+
+        QCBOREncode_CloseArray(&ctx->encode_context);
+    }
+
+    ctx->pending_frames++;
+
+    return AQ_OK;
+}
+
+static int sensor_aq_encode_frame_i16(sensor_aq_ctx *ctx, const int16_t *values, size_t values_size) {
+    int fr = sensor_aq_reserve_frame(ctx, values_size);
+    if (fr != AQ_OK) {
+        return fr;
+    }
+
+    if (values_size == 1) {
+        QCBOREncode_AddInt64(&ctx->encode_context, values[0]);
+    }
+    else {
+        QCBOREncode_OpenArray(&ctx->encode_context);
+
+        for (size_t ix = 0; ix < values_size; ix++) {
+            QCBOREncode_AddInt64(&ctx->encode_context, values[ix]);
+        }
+
+        QCBOREncode_CloseArray(&ctx->encode_context);
+    }
+
+    ctx->pending_frames++;
+
+    return AQ_OK;
+}
+
+/**
+ * Add data to the sensor file for a single interval, encoding floats as float16/float32.
+ * Frames are collected in the CBOR buffer and only written to the stream (and signature)
+ * when the buffer is full, call sensor_aq_flush() or sensor_aq_finish() when done.
+ * @param ctx The context
+ * @param values Values for the current frame
+ * @param values_size Size of the values
+ * @param encoding Float encoding, AQ_FLOAT_HALF trades precision for size
+ */
+int sensor_aq_add_data_compact(sensor_aq_ctx *ctx, float values[], size_t values_size, sensor_aq_float_encoding encoding) {
+    if (values_size != ctx->axis_count) {
+        return AQ_VALUES_SIZE_DOES_NOT_MATCH_AXIS_COUNT;
+    }
+
+    if (ctx->stream == NULL) {
+        return AQ_STREAM_IS_NULL;
+    }
+
+    return sensor_aq_encode_frame(ctx, values, values_size, encoding);
+}
+
+/**
+ * Add data to the sensor file for many intervals at the same time, any number of axes.
+ * The frames are encoded in one pass, the stream and signature are only updated
+ * once per full CBOR buffer and once at the end.
+ * @param ctx The context
+ * @param values frame_count frames of values_size values each (frame after frame)
+ * @param frame_count Number of frames
+ * @param values_size Number of values per frame
+ * @param encoding Float encoding, AQ_FLOAT_HALF trades precision for size
+ */
+int sensor_aq_add_frames(sensor_aq_ctx *ctx, const float values[], size_t frame_count, size_t values_size, sensor_aq_float_encoding encoding) {
+    if (values_size != ctx->axis_count) {
+        return AQ_VALUES_SIZE_DOES_NOT_MATCH_AXIS_COUNT;
+    }
+
+    if (ctx->stream == NULL) {
+        return AQ_STREAM_IS_NULL;
+    }
+
+    for (size_t frame = 0; frame < frame_count; frame++) {
+        int fr = sensor_aq_encode_frame(ctx, values + (frame * values_size), values_size, encoding);
+        if (fr != AQ_OK) {
+            return fr;
+        }
+    }
+
+    return sensor_aq_flush(ctx);
+}
+
+/**
+ * Add int16 data to the sensor file for many intervals at the same time, any number of axes.
+ * @param ctx The context
+ * @param values frame_count frames of values_size values each (frame after frame)
+ * @param frame_count Number of frames
+ * @param values_size Number of values per frame
+ */
+int sensor_aq_add_frames_i16(sensor_aq_ctx *ctx, const int16_t values[], size_t frame_count, size_t values_size) {
+    if (values_size != ctx->axis_count) {
+        return AQ_VALUES_SIZE_DOES_NOT_MATCH_AXIS_COUNT;
+    }
+
+    if (ctx->stream == NULL) {
+        return AQ_STREAM_IS_NULL;
+    }
+
+    for (size_t frame = 0; frame < frame_count; frame++) {
+        int fr = sensor_aq_encode_frame_i16(ctx, values + (frame * values_size), values_size);
+        if (fr != AQ_OK) {
+            return fr;
+        }
+    }
+
+    return sensor_aq_flush(ctx);
+}
+
+/**
+ * Write frames buffered by sensor_aq_add_data_compact() to the stream
+ * @param ctx The context
+ */
+int sensor_aq_flush(sensor_aq_ctx *ctx) {
+    if (ctx->pending_frames == 0) {
+        return AQ_OK;
+    }
+
+    return sensor_aq_flush_buffer(ctx);
+}
+
 int sensor_aq_finish(sensor_aq_ctx *ctx) {
     uint8_t final_byte[] = { 0xff };
 
@@ -475,6 +673,11 @@ int sensor_aq_finish(sensor_aq_ctx *ctx) {
         return AQ_STREAM_IS_NULL;
     }
 
+    int fr = sensor_aq_flush(ctx);
+    if (fr != AQ_OK) {
+        return fr;
+    }
+
     // Update the signature
     int ctx_err = ctx->signature_ctx->update(ctx->signature_ctx, final_byte, 1);
     if (ctx_err != 0) {
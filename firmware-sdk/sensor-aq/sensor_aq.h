@@ -91,6 +91,16 @@ typedef enum {
     AQ_OUT_OF_MEM = -6020
 } sensor_aq_status;
 
+/**
+ * How sensor_aq_add_data_compact() and sensor_aq_add_frames() encode float values
+ */
+typedef enum {
+    // float16 if the value converts without losing precision, float32 otherwise
+    AQ_FLOAT_LOSSLESS = 0,
+    // float16 whenever the value is in the normal float16 range (~3 significant digits), float32 otherwise
+    AQ_FLOAT_HALF = 1
+} sensor_aq_float_encoding;
+
 /**
  * Buffer context
  */
@@ -172,6 +182,9 @@ typedef struct {
 
     // active stream
     EI_SENSOR_AQ_STREAM *stream;
+
+    // frames encoded in the CBOR buffer that are not written to the stream yet
+    size_t pending_frames;
 } sensor_aq_ctx;
 
 /**
@@ -206,6 +219,10 @@ int sensor_aq_init(sensor_aq_ctx *ctx, sensor_aq_payload_info *payload_info, EI_
 int sensor_aq_add_data(sensor_aq_ctx *ctx, float values[], size_t values_size);
 int sensor_aq_add_data_i16(sensor_aq_ctx *ctx, int16_t values[], size_t values_size);
 int sensor_aq_add_data_batch(sensor_aq_ctx *ctx, int16_t values[], size_t values_size);
+int sensor_aq_add_data_compact(sensor_aq_ctx *ctx, float values[], size_t values_size, sensor_aq_float_encoding encoding);
+int sensor_aq_add_frames(sensor_aq_ctx *ctx, const float values[], size_t frame_count, size_t values_size, sensor_aq_float_encoding encoding);
+int sensor_aq_add_frames_i16(sensor_aq_ctx *ctx, const int16_t values[], size_t frame_count, size_t values_size);
+int sensor_aq_flush(sensor_aq_ctx *ctx);
 int sensor_aq_finish(sensor_aq_ctx *ctx);
 
 #endif /* EI_SENSOR_AQ_H */
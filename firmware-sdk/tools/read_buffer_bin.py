@@ -0,0 +1,205 @@
+import os
+import sys
+import time
+import struct
+import random
+import argparse
+import binascii
+import threading
+
+FRAME_MAGIC = b"EI"
+FRAME_HEADER = struct.Struct("<HIH")  # seq, offset, length
+FRAME_CRC = struct.Struct("<I")
+FRAME_PAYLOAD_SIZE = 512
+ACK = b"\x06"
+NAK = b"\x15"
+
+
+class FrameError(Exception):
+    pass
+
+
+def read_exact(ser, size):
+    data = ser.read(size)
+    if len(data) != size:
+        raise FrameError("timeout, got {} of {} bytes".format(len(data), size))
+    return data
+
+
+def drain(ser, quiet_time=0.2):
+    """ Drop the rest of a bad window, i.e. read until the line is quiet """
+    timeout = ser.timeout
+    ser.timeout = quiet_time
+    while ser.read(4096):
+        pass
+    ser.timeout = timeout
+
+
+def await_line(ser, response):
+    while True:
+        line = ser.readline()
+        if not line:
+            raise FrameError("timeout waiting for {}".format(response))
+        print(line)
+        if line.strip() == response.encode():
+            return
+
+
+def read_frame(ser, expected_seq, expected_offset):
+    # skip anything before the magic (e.g. echo of the AT command)
+    window = b""
+    while window != FRAME_MAGIC:
+        window = (window + read_exact(ser, 1))[-2:]
+
+    header = read_exact(ser, FRAME_HEADER.size)
+    seq, offset, length = FRAME_HEADER.unpack(header)
+    if length > FRAME_PAYLOAD_SIZE:
+        raise FrameError("bad length {}".format(length))
+    payload = read_exact(ser, length)
+    (crc,) = FRAME_CRC.unpack(read_exact(ser, FRAME_CRC.size))
+
+    if binascii.crc32(header + payload) != crc:
+        raise FrameError("CRC mismatch in frame {}".format(seq))
+    if seq != expected_seq or offset != expected_offset:
+        raise FrameError("expected frame {} @ {}, got {} @ {}".format(expected_seq, expected_offset, seq, offset))
+
+    return payload
+
+
+def read_buffer(ser, start, length, window=0, max_rate=False, retries=5):
+    """ Read LENGTH bytes from START, resuming from the last good offset on errors """
+    data = b""
+
+    while retries >= 0:
+        offset = start + len(data)
+        ser.reset_input_buffer()
+        ser.write("AT+READBUFFERBIN={},{},{},{}\r".format(offset, length - len(data),
+                                                         "y" if max_rate else "n", window).encode())
+        try:
+            await_line(ser, "OK")
+            seq = 0
+            window_data = b""
+            while True:
+                try:
+                    payload = read_frame(ser, seq, offset + len(window_data))
+                except FrameError as e:
+                    if window == 0:
+                        raise
+                    print("{}, NAK".format(e))
+                    drain(ser)
+                    ser.write(NAK)
+                    seq -= seq % window
+                    window_data = b""
+                    continue
+
+                window_data += payload
+                seq += 1
+                if window and (seq % window == 0 or len(payload) == 0):
+                    ser.write(ACK)
+                if window == 0 or seq % window == 0 or len(payload) == 0:
+                    data += window_data
+                    offset += len(window_data)
+                    window_data = b""
+                if len(payload) == 0:
+                    return data
+        except FrameError as e:
+            print("{}, resuming from {}".format(e, start + len(data)))
+            retries -= 1
+            time.sleep(1)
+
+    raise FrameError("too many retries")
+
+
+def emulate_device(fd, memory, corrupt_rate, crlf=False):
+    """ Stand-in for the device side of AT+READBUFFERBIN on a pseudo-terminal.
+    With CRLF, frames go through the same LF -> CRLF translation as a retarget-io
+    stdout would apply, i.e. what the frames look like if sent with ei_putchar. """
+    rx = b""
+    while True:
+        try:
+            chunk = os.read(fd, 256)
+        except OSError:
+            return
+        rx += chunk
+        if b"\r" not in rx:
+            continue
+        line, rx = rx.split(b"\r", 1)
+        if not line.startswith(b"AT+READBUFFERBIN="):
+            continue
+
+        args = line.split(b"=", 1)[1].split(b",")
+        start, length = int(args[0]), int(args[1])
+        window = int(args[3]) if len(args) > 3 else 0
+        os.write(fd, b"OK\r\n")
+
+        frames = []
+        for pos in range(start, start + length, FRAME_PAYLOAD_SIZE):
+            frames.append((pos, memory[pos:min(pos + FRAME_PAYLOAD_SIZE, start + length)]))
+        frames.append((start + length, b""))
+
+        ix = 0
+        while ix < len(frames):
+            end = len(frames) if window == 0 else min(ix + window, len(frames))
+            for seq in range(ix, end):
+                offset, payload = frames[seq]
+                header = FRAME_HEADER.pack(seq & 0xffff, offset, len(payload))
+                crc = binascii.crc32(header + payload)
+                if payload and random.random() < corrupt_rate:
+                    payload = bytes([payload[0] ^ 0xff]) + payload[1:]
+                frame = FRAME_MAGIC + header + payload + FRAME_CRC.pack(crc)
+                os.write(fd, frame.replace(b"\n", b"\r\n") if crlf else frame)
+            if window == 0:
+                break
+            ack = os.read(fd, 1)
+            if ack == ACK:
+                ix = end
+            elif ack != NAK:
+                break
+        os.write(fd, b"\r\nOK\r\n")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Receive sample buffer with AT+READBUFFERBIN")
+    parser.add_argument("port", nargs="?", help="device port, e.g. /dev/ttyACM0")
+    parser.add_argument("--start", type=int, default=0)
+    parser.add_argument("--length", type=int, default=4096)
+    parser.add_argument("--window", type=int, default=0, help="frames per ACK, 0 disables ACKs")
+    parser.add_argument("--max-rate", action="store_true", help="switch the device to max baudrate")
+    parser.add_argument("--baudrate", type=int, default=115200)
+    parser.add_argument("--output", help="file to store received data")
+    parser.add_argument("--emulate", action="store_true",
+                        help="talk to an emulated device over a pseudo-terminal instead of a port")
+    parser.add_argument("--corrupt", type=float, default=0.0, help="emulated frame corruption rate")
+    parser.add_argument("--crlf", action="store_true",
+                        help="emulate frames sent through a stdout that converts LF to CRLF")
+    args = parser.parse_args()
+
+    import serial
+
+    memory = None
+    if args.emulate:
+        import pty
+        import tty
+        memory = bytes(random.getrandbits(8) for _ in range(args.start + args.length))
+        master, slave = pty.openpty()
+        tty.setraw(slave)
+        threading.Thread(target=emulate_device, args=(master, memory, args.corrupt, args.crlf), daemon=True).start()
+        args.port = os.ttyname(slave)
+    elif args.port is None:
+        parser.error("port is required without --emulate")
+
+    ser = serial.Serial(args.port, args.baudrate, timeout=2)
+    start_time = time.time()
+    data = read_buffer(ser, args.start, args.length, args.window, args.max_rate)
+    elapsed = time.time() - start_time
+    ser.close()
+
+    print("Received {} bytes in {:.2f} s".format(len(data), elapsed))
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(data)
+    if memory is not None:
+        if data != memory[args.start:args.start + args.length]:
+            print("Data mismatch!")
+            sys.exit(1)
+        print("Data matches")
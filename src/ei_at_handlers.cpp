@@ -38,6 +38,7 @@
 #include "ei_device_psoc62.h"
 #include "ei_run_impulse.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/classifier/ei_op_profile.h"
 #include "firmware-sdk/ei_fusion.h"
 #include "firmware-sdk/ei_device_info_lib.h"
 #include "firmware-sdk/ei_device_lib.h"
@@ -326,6 +327,46 @@ bool at_read_buffer(const char **argv, const int argc)
     return true;
 }
 
+bool at_read_buffer_bin(const char **argv, const int argc)
+{
+    if(argc < 2) {
+        ei_printf("Missing argument! Required: " AT_READBUFFERBIN_ARGS "\n");
+        return true;
+    }
+    bool success = true;
+
+    size_t start = (size_t)atoi(argv[0]);
+    size_t length = (size_t)atoi(argv[1]);
+    bool use_max_baudrate = (argc >= 3 && argv[2][0] == 'y');
+    uint32_t window = (argc >= 4) ? (uint32_t)atoi(argv[3]) : 0;
+
+    dev->set_state(eiStateUploading);
+
+    ei_printf("OK\n");
+    if (use_max_baudrate) {
+        dev->set_max_data_output_baudrate();
+        ei_sleep(100);
+    }
+
+    success = read_send_sample_buffer_framed(start, length, window);
+
+    if (use_max_baudrate) {
+        ei_sleep(100);
+        dev->set_default_data_output_baudrate();
+    }
+
+    if (!success) {
+        ei_printf("\nERR: Failed to send buffer\n");
+        dev->set_state(eiStateIdle);
+    }
+    else {
+        ei_printf("\nOK\n");
+        dev->set_state(eiStateFinished);
+    }
+
+    return true;
+}
+
 bool at_get_upload_settings(void)
 {
     ei_printf("Api Key:   %s\n", dev->get_upload_api_key().c_str());
@@ -403,6 +444,25 @@ bool at_run_impulse_cont(void)
     return false;
 }
 
+bool at_run_impulse_sched(const char **argv, const int argc)
+{
+    if(check_args_num(2, argc) == false) {
+        return true;
+    }
+
+    uint32_t period_ms = (uint32_t)atoi(argv[0]);
+    uint32_t window_ms = (uint32_t)atoi(argv[1]);
+
+    if(window_ms == 0 || period_ms < window_ms) {
+        ei_printf("ERR: PERIOD_MS has to be greater than or equal to WINDOW_MS\n");
+        return true;
+    }
+
+    ei_start_impulse_scheduled(period_ms, window_ms, false);
+
+    return false;
+}
+
 bool at_run_impulse_static_data(const char **argv, const int argc)
 {
 
@@ -425,6 +485,29 @@ bool at_stop_impulse(void)
     return true;
 }
 
+bool at_get_sample_clock(void)
+{
+    dev->print_sample_clock_stats();
+
+    return true;
+}
+
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+bool at_get_op_profile(void)
+{
+    ei_op_profile_print();
+
+    return true;
+}
+
+bool at_clear_op_profile(void)
+{
+    ei_op_profile_reset();
+
+    return true;
+}
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
+
 ATServer *ei_at_init(EiDevicePSoC62 *device)
 {
     ATServer *at;
@@ -439,14 +522,20 @@ ATServer *ei_at_init(EiDevicePSoC62 *device)
     at->register_command(AT_SAMPLESETTINGS, AT_SAMPLESETTINGS_HELP_TEXT, nullptr, at_get_sample_settings, at_set_sample_settings, AT_SAMPLESETTINGS_ARGS);
     at->register_command(AT_MGMTSETTINGS, AT_MGMTSETTINGS_HELP_TEXT, nullptr, at_get_mgmt_url, at_set_mgmt_url, AT_MGMTSETTINGS_ARGS);
     at->register_command(AT_READBUFFER, AT_READBUFFER_HELP_TEXT, nullptr, nullptr, at_read_buffer, AT_READBUFFER_ARGS);
+    at->register_command(AT_READBUFFERBIN, AT_READBUFFERBIN_HELP_TEXT, nullptr, nullptr, at_read_buffer_bin, AT_READBUFFERBIN_ARGS);
     at->register_command(AT_UPLOADSETTINGS, AT_UPLOADSETTINGS_HELP_TEXT, nullptr, at_get_upload_settings, at_set_upload_settings, AT_UPLOADSETTINGS_ARGS);
     at->register_command(AT_UPLOADHOST, AT_UPLOADHOST_HELP_TEXT, nullptr, at_get_upload_host, at_set_upload_host, AT_UPLOADHOST_ARGS);
     at->register_command(AT_UNLINKFILE, AT_UNLINKFILE_HELP_TEXT, nullptr, nullptr, at_unlink_file, AT_UNLINKFILE_ARGS);
     at->register_command(AT_RUNIMPULSE, AT_RUNIMPULSE_HELP_TEXT, at_run_impulse, nullptr, nullptr, nullptr);
     at->register_command(AT_RUNIMPULSEDEBUG, AT_RUNIMPULSEDEBUG_HELP_TEXT, nullptr, nullptr, at_run_impulse_debug, AT_RUNIMPULSEDEBUG_ARGS);
     at->register_command(AT_RUNIMPULSECONT, AT_RUNIMPULSECONT_HELP_TEXT, at_run_impulse_cont, nullptr, nullptr, nullptr);
+    at->register_command(AT_RUNIMPULSESCHED, AT_RUNIMPULSESCHED_HELP_TEXT, nullptr, nullptr, at_run_impulse_sched, AT_RUNIMPULSESCHED_ARGS);
     at->register_command("STOPIMPULSE", "", at_stop_impulse, nullptr, nullptr, nullptr);
     at->register_command(AT_RUNIMPULSESTATIC, AT_RUNIMPULSESTATIC_HELP_TEXT, nullptr, nullptr, at_run_impulse_static_data, AT_RUNIMPULSESTATIC_ARGS);
+    at->register_command(AT_SAMPLECLOCK, AT_SAMPLECLOCK_HELP_TEXT, nullptr, at_get_sample_clock, nullptr, nullptr);
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    at->register_command(AT_OPPROFILE, AT_OPPROFILE_HELP_TEXT, at_clear_op_profile, at_get_op_profile, nullptr, nullptr);
+#endif
 
     return at;
 }
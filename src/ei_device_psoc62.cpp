@@ -34,13 +34,17 @@
 
 
 #include <string>
+#include <cstring>
 
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "firmware-sdk/ei_device_info_lib.h"
 #include "firmware-sdk/ei_device_memory.h"
+#include "firmware-sdk/ei_device_lib.h"
+#include "firmware-sdk/at_base64_lib.h"
 #include "ei_device_psoc62.h"
 #include "ei_flash_memory.h"
 #include "ei_environment_sensor.h"
+#include "ei_inertial_sensor.h"
 #include "ei_microphone.h"
 #include "cy_syslib.h"
 #include "cyhal_gpio.h"
@@ -48,6 +52,7 @@
 #ifdef FREERTOS_ENABLED
 #include <FreeRTOS.h>
 #include <timers.h>
+#include <task.h>
 #endif
 
 
@@ -61,20 +66,160 @@
 #define FLASH_TEST_SIZE (512u)
 #define FLASH_TEST_ADDR (0x1000)
 
+/* Sample export, multiple of 3 so only the last block gets base64 padding */
+#define READ_BUFFER_BLOCK_SIZE  (768u)
+#define READ_BUFFER_TX_SIZE     (READ_BUFFER_BLOCK_SIZE / 3 * 4)
+
+#define PERIODIC_TIMER_CLOCK_HZ (1000000) /* 1 MHz */
+#define PERIODIC_TIMER_PRIORITY 7
+
+/* Sample clock. A TCPWM counter at PERIODIC_TIMER_CLOCK_HZ, its period is adjusted on every
+ * tick so fractional intervals average out exactly (e.g. 3333 us + 1/3 us for 300 Hz) */
+#define SAMPLE_CLOCK_FRAC_DEN           1000 /* fractional part of the interval in ns */
+#define SAMPLE_CLOCK_JITTER_BUCKETS     8
+/* Sample callback runs above the timer service and flash writer tasks */
+#define SAMPLE_TASK_PRIORITY            (4u)
+#define SAMPLE_TASK_STACK_SIZE          (1024u)
+
+typedef struct {
+    float interval_ms;
+    uint32_t base_period_us;     /* integer part of the interval */
+    uint32_t frac_ns;            /* fractional part, 0..SAMPLE_CLOCK_FRAC_DEN-1 */
+    uint32_t frac_acc;
+    uint32_t current_period_us;  /* period of the running cycle */
+    volatile uint64_t tick_time_us; /* sample clock time of the last tick */
+    volatile uint32_t ticks;
+    volatile uint32_t tick_ref_ms;  /* RTOS tick (ms) at the last tick, to measure drift against */
+    uint32_t first_ref_ms;
+    uint64_t first_tick_us;
+    uint64_t sample_time_us;     /* tick handled by the running sample callback */
+    uint32_t handled;
+    uint32_t missed;             /* ticks skipped because the previous sample was still busy */
+    uint32_t max_latency_us;
+    uint32_t latency_hist[SAMPLE_CLOCK_JITTER_BUCKETS];
+} sample_clock_t;
+
+/* upper bounds (exclusive) of the latency histogram buckets, last bucket takes the rest */
+static const uint32_t sample_latency_limits_us[SAMPLE_CLOCK_JITTER_BUCKETS - 1] = { 10, 50, 100, 500, 1000, 5000, 10000 };
+
+static cyhal_timer_t sample_timer;
+static sample_clock_t sample_clock;
+static void (*sample_cb_ptr)(void);
+
 #ifdef FREERTOS_ENABLED
 /** Global objects */
-TimerHandle_t fusion_timer;
 TimerHandle_t led_timer;
-void (*sample_cb_ptr)(void);
+static TaskHandle_t sample_task;
+static StaticTask_t sample_task_buffer;
+static StackType_t sample_task_stack[SAMPLE_TASK_STACK_SIZE];
 /* Private function declarations ------------------------------------------- */
-void vTimerCallback(TimerHandle_t xTimer);
 void vLedCallback(TimerHandle_t xTimer);
-#else /* bare-metal case */
-#define PERIODIC_TIMER_CLOCK_HZ (1000000) /* 1 MHz */
-#define PERIODIC_TIMER_PRIORITY 7
+static void sample_task_handler(void *arg);
+#endif
+
+/**
+ * @brief Sample clock time (us) now, i.e. the last tick plus the counter value
+ */
+static uint64_t sample_clock_now_us(void)
+{
+    uint32_t irq = cyhal_system_critical_section_enter();
+    uint64_t now = sample_clock.tick_time_us + cyhal_timer_read(&sample_timer);
+    cyhal_system_critical_section_exit(irq);
+
+    return now;
+}
+
+/**
+ * @brief Millisecond tick that doesn't come from the sample timer, can be read in the ISR
+ */
+static uint32_t sample_clock_ref_ms_from_isr(void)
+{
+#ifdef FREERTOS_ENABLED
+    return xTaskGetTickCountFromISR() * portTICK_PERIOD_MS;
+#else
+    return (uint32_t)ei_read_timer_ms();
+#endif
+}
+
+/**
+ * @brief Run the sample callback for the tick at sample_clock.tick_time_us
+ *        and record how late it started
+ */
+static void sample_clock_run_callback(void)
+{
+    /* 64 bit, updated by the ISR */
+    uint32_t irq = cyhal_system_critical_section_enter();
+    sample_clock.sample_time_us = sample_clock.tick_time_us;
+    cyhal_system_critical_section_exit(irq);
+
+    uint32_t latency = (uint32_t)(sample_clock_now_us() - sample_clock.sample_time_us);
+    uint32_t bucket = 0;
+    while(bucket < SAMPLE_CLOCK_JITTER_BUCKETS - 1 && latency >= sample_latency_limits_us[bucket]) {
+        bucket++;
+    }
+    sample_clock.latency_hist[bucket]++;
+    if(latency > sample_clock.max_latency_us) {
+        sample_clock.max_latency_us = latency;
+    }
+    sample_clock.handled++;
+
+    sample_cb_ptr();
+}
+
+/**
+ * @brief Terminal count of the sample timer. The counter restarted from 0 already,
+ *        so the period of the running cycle can still be set (Bresenham accumulation).
+ */
+static void sample_clock_isr(void *callback_arg, cyhal_timer_event_t event)
+{
+    uint32_t period = sample_clock.base_period_us;
+
+    sample_clock.tick_time_us += sample_clock.current_period_us;
+    sample_clock.tick_ref_ms = sample_clock_ref_ms_from_isr();
+    if(sample_clock.ticks++ == 0) {
+        sample_clock.first_tick_us = sample_clock.tick_time_us;
+        sample_clock.first_ref_ms = sample_clock.tick_ref_ms;
+    }
+
+    sample_clock.frac_acc += sample_clock.frac_ns;
+    if(sample_clock.frac_acc >= SAMPLE_CLOCK_FRAC_DEN) {
+        sample_clock.frac_acc -= SAMPLE_CLOCK_FRAC_DEN;
+        period++;
+    }
+
+    if(period != sample_clock.current_period_us) {
+        /* no HAL API to change the period without re-initializing the counter */
+        Cy_TCPWM_Counter_SetPeriod(sample_timer.tcpwm.base, sample_timer.tcpwm.resource.channel_num, period - 1);
+        sample_clock.current_period_us = period;
+    }
+
+#ifdef FREERTOS_ENABLED
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(sample_task, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+#else
+    sample_clock_run_callback();
 #endif
+}
+
+#ifdef FREERTOS_ENABLED
+static void sample_task_handler(void *arg)
+{
+    while(1) {
+        uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if(sample_cb_ptr == nullptr) {
+            continue;
+        }
+
+        if(pending > 1) {
+            sample_clock.missed += pending - 1;
+        }
 
-typedef void (*timer_callback_t) (void*, cyhal_timer_event_t);
+        sample_clock_run_callback();
+    }
+}
+#endif
 
 void led_handler(void *callback_arg, cyhal_timer_event_t event)
 {
@@ -187,7 +332,9 @@ EiDevicePSoC62::EiDevicePSoC62(EiDeviceMemory* mem)
                             vLedCallback
                         );
     xTimerStart(led_timer, 0);
-    // sample timer is created in start_sample_thread()
+
+    sample_task = xTaskCreateStatic(sample_task_handler, "Sampler", SAMPLE_TASK_STACK_SIZE,
+                                    NULL, SAMPLE_TASK_PRIORITY, sample_task_stack, &sample_task_buffer);
 #else /* bare-metal */
     // create LED timer
     const cyhal_timer_cfg_t led_timer_cfg =
@@ -204,19 +351,23 @@ EiDevicePSoC62::EiDevicePSoC62(EiDeviceMemory* mem)
     cyhal_timer_set_frequency(&led_timer, PERIODIC_TIMER_CLOCK_HZ);
     cyhal_timer_register_callback(&led_timer, led_handler, this);
     cyhal_timer_enable_event(&led_timer, CYHAL_TIMER_IRQ_TERMINAL_COUNT, 7, true);
+#endif
 
-    // pre-configure sample timer
-    sample_timer_cfg.is_continuous = true;
-    sample_timer_cfg.direction = CYHAL_TIMER_DIR_UP;
-    sample_timer_cfg.is_compare = false;
-    sample_timer_cfg.period = 100 * 1000;
-    sample_timer_cfg.compare_value = 0;
-    sample_timer_cfg.value = 0;
+    // pre-configure sample timer, period is set in start_sample_thread()
+    const cyhal_timer_cfg_t sample_timer_cfg =
+    {
+        .is_continuous = true,
+        .direction = CYHAL_TIMER_DIR_UP,
+        .is_compare = false,
+        .period = 100 * 1000,
+        .compare_value = 0,
+        .value = 0
+    };
     cyhal_timer_init(&sample_timer, NC, NULL);
     cyhal_timer_configure(&sample_timer, &sample_timer_cfg);
     cyhal_timer_set_frequency(&sample_timer, PERIODIC_TIMER_CLOCK_HZ);
-    cyhal_timer_enable_event(&sample_timer, CYHAL_TIMER_IRQ_TERMINAL_COUNT, 7, true);
-#endif
+    cyhal_timer_register_callback(&sample_timer, sample_clock_isr, nullptr);
+    cyhal_timer_enable_event(&sample_timer, CYHAL_TIMER_IRQ_TERMINAL_COUNT, PERIODIC_TIMER_PRIORITY, true);
 
     sensors[EI_STANDALONE_SENSOR_MIC].name = "Microphone";
     sensors[EI_STANDALONE_SENSOR_MIC].start_sampling_cb = ei_microphone_sample_start;
@@ -334,21 +485,36 @@ bool EiDevicePSoC62::start_sample_thread(void (*sample_read_cb)(void), float sam
     cy_rslt_t result;
     bool ret = false;
 
-#ifdef FREERTOS_ENABLED
+    if(!this->is_environmental_sampling() && ei_fusion_is_sensor_connected(&ei_fusion_inertial_sensor_read_data)) {
+        /* IMU runs from its FIFO if the interval matches its ODR, otherwise it's read on every tick */
+        ei_inertial_sensor_fifo_start(sample_interval_ms);
+    }
+
+    uint32_t interval_ns = (uint32_t)(sample_interval_ms * 1000000.0f + 0.5f);
+
+    memset(&sample_clock, 0, sizeof(sample_clock));
+    sample_clock.interval_ms = sample_interval_ms;
+    sample_clock.base_period_us = interval_ns / SAMPLE_CLOCK_FRAC_DEN;
+    sample_clock.frac_ns = interval_ns % SAMPLE_CLOCK_FRAC_DEN;
+    sample_clock.current_period_us = sample_clock.base_period_us;
     sample_cb_ptr = sample_read_cb;
-    fusion_timer = xTimerCreate("Fusion sampler",
-                                (uint32_t)sample_interval_ms / portTICK_PERIOD_MS,
-                                pdTRUE, (void *) 0, vTimerCallback);
+#ifdef FREERTOS_ENABLED
+    /* drop a tick left pending from the previous sampling */
+    ulTaskNotifyValueClear(sample_task, UINT32_MAX);
+#endif
 
-    if(xTimerStart(fusion_timer, 0) == pdPASS) {
-#else
-    /* Assign the ISR to execute on timer interrupt */
-    sample_timer_cfg.period = sample_interval_ms * 1000;
+    const cyhal_timer_cfg_t sample_timer_cfg =
+    {
+        .is_continuous = true,
+        .direction = CYHAL_TIMER_DIR_UP,
+        .is_compare = false,
+        .period = sample_clock.base_period_us - 1, /* counts 0..period */
+        .compare_value = 0,
+        .value = 0
+    };
     cyhal_timer_configure(&sample_timer, &sample_timer_cfg);
-    cyhal_timer_register_callback(&sample_timer, (timer_callback_t)sample_read_cb, nullptr);
     result = cyhal_timer_start(&sample_timer);
     if (result == CY_RSLT_SUCCESS) {
-#endif
         if(this->is_environmental_sampling()) {
             /* Workaround for ADC issue */
             ei_environment_sensor_async_trigger();
@@ -365,14 +531,8 @@ bool EiDevicePSoC62::start_sample_thread(void (*sample_read_cb)(void), float sam
 
 bool EiDevicePSoC62::stop_sample_thread(void)
 {
-#ifdef FREERTOS_ENABLED
-    if (xTimerStop(fusion_timer, 0) != pdPASS)
-    {
-        ei_printf("ERR: timer has not been stopped \n");
-    }
-#else
     cyhal_timer_stop(&sample_timer);
-#endif
+    ei_inertial_sensor_fifo_stop();
     this->set_state(eiStateIdle);
 
     return true;
@@ -429,12 +589,131 @@ bool EiDevicePSoC62::is_environmental_sampling(void)
     return this->environmental_sampling;
 }
 
-#ifdef FREERTOS_ENABLED
-void vTimerCallback(TimerHandle_t xTimer)
+/**
+ * @brief Sample clock time (us since start_sample_thread) of the tick
+ *        the sample callback is running for
+ */
+uint64_t EiDevicePSoC62::get_sample_timestamp_us(void)
 {
-    sample_cb_ptr();
+    return sample_clock.sample_time_us;
 }
 
+/**
+ * @brief Print sample clock statistics of the last (or running) sampling
+ */
+void EiDevicePSoC62::print_sample_clock_stats(void)
+{
+    uint32_t irq = cyhal_system_critical_section_enter();
+    uint64_t tick_time_us = sample_clock.tick_time_us;
+    uint32_t ticks = sample_clock.ticks;
+    uint32_t tick_ref_ms = sample_clock.tick_ref_ms;
+    cyhal_system_critical_section_exit(irq);
+
+    /* sample clock time between the first and the last tick against the RTOS tick (+-1 ms) */
+    int64_t clock_us = (int64_t)(tick_time_us - sample_clock.first_tick_us);
+    int64_t ref_us = (int64_t)(tick_ref_ms - sample_clock.first_ref_ms) * 1000;
+
+    ei_printf("Interval: ");
+    ei_printf_float(sample_clock.interval_ms);
+    ei_printf(" ms (%lu us + %lu/%u us)\n", sample_clock.base_period_us, sample_clock.frac_ns, SAMPLE_CLOCK_FRAC_DEN);
+    ei_printf("Ticks: %lu, handled: %lu, missed: %lu\n", ticks, sample_clock.handled, sample_clock.missed);
+    ei_printf("Drift against the ms tick: %ld us", (long)(clock_us - ref_us));
+    if(ref_us > 0) {
+        ei_printf(" (%ld ppm)", (long)((double)(clock_us - ref_us) * 1000000.0 / (double)ref_us));
+    }
+    ei_printf("\n");
+    ei_printf("Callback latency (us):\n");
+    for(uint32_t i = 0; i < SAMPLE_CLOCK_JITTER_BUCKETS; i++) {
+        if(i < SAMPLE_CLOCK_JITTER_BUCKETS - 1) {
+            ei_printf("\t< %lu: %lu\n", sample_latency_limits_us[i], sample_clock.latency_hist[i]);
+        }
+        else {
+            ei_printf("\t>= %lu: %lu\n", sample_latency_limits_us[i - 1], sample_clock.latency_hist[i]);
+        }
+    }
+    ei_printf("\tmax: %lu\n", sample_clock.max_latency_us);
+    ei_inertial_sensor_print_fifo_stats();
+}
+
+/**
+ * @brief Non-blocking read from the debug UART (retarget-io getchar blocks)
+ *
+ * @return received character or 0 if there is none
+ */
+char ei_getchar(void)
+{
+    uint8_t c = 0;
+
+    if(cyhal_uart_readable(&cy_retarget_io_uart_obj) > 0) {
+        cyhal_uart_getc(&cy_retarget_io_uart_obj, &c, 0);
+    }
+
+    return (char)c;
+}
+
+/**
+ * @brief Read sample data, base64 encode it and send it over the debug UART.
+ * Overrides the firmware-sdk version that sends one character per ei_putchar call.
+ * Blocks are encoded into two TX buffers in turn, so reading and encoding the
+ * next block overlaps with the asynchronous UART transfer of the previous one.
+ */
+bool read_encode_send_sample_buffer(size_t address, size_t length)
+{
+    static uint8_t read_buffer[READ_BUFFER_BLOCK_SIZE];
+    static char tx_buffers[2][READ_BUFFER_TX_SIZE];
+    EiDeviceMemory *memory = EiDeviceInfo::get_device()->get_memory();
+    uint8_t tx_ix = 0;
+    bool ret = true;
+
+    while(length > 0) {
+        size_t bytes_to_read = length < READ_BUFFER_BLOCK_SIZE ? length : READ_BUFFER_BLOCK_SIZE;
+
+        if(memory->read_sample_data(read_buffer, address, bytes_to_read) != bytes_to_read) {
+            ret = false;
+            break;
+        }
+
+        size_t tx_size = base64_encode_block(read_buffer, bytes_to_read, tx_buffers[tx_ix]);
+
+        /* other buffer still going out */
+        while(cyhal_uart_is_tx_active(&cy_retarget_io_uart_obj));
+
+        if(cyhal_uart_write_async(&cy_retarget_io_uart_obj, tx_buffers[tx_ix], tx_size) != CY_RSLT_SUCCESS) {
+            ret = false;
+            break;
+        }
+
+        tx_ix ^= 1;
+        address += bytes_to_read;
+        length -= bytes_to_read;
+    }
+
+    /* don't let the caller print over or re-clock an ongoing transfer */
+    while(cyhal_uart_is_tx_active(&cy_retarget_io_uart_obj));
+
+    return ret;
+}
+
+/**
+ * @brief Send binary data (e.g. AT+READBUFFERBIN frames) straight to the debug UART.
+ * Going through ei_putchar/stdout would let retarget-io insert a CR before every LF byte.
+ * Same asynchronous block transfer as above, the caller alternates two buffers.
+ */
+void ei_write_raw(const uint8_t *data, size_t length)
+{
+    /* previous block still going out */
+    while(cyhal_uart_is_tx_active(&cy_retarget_io_uart_obj));
+
+    if(length == 0) {
+        return;
+    }
+
+    if(cyhal_uart_write_async(&cy_retarget_io_uart_obj, (void *)data, length) != CY_RSLT_SUCCESS) {
+        cyhal_uart_write(&cy_retarget_io_uart_obj, (void *)data, &length);
+    }
+}
+
+#ifdef FREERTOS_ENABLED
 void vLedCallback(TimerHandle_t xTimer) {
     led_handler(pvTimerGetTimerID(xTimer), (cyhal_timer_event_t)0);
 }
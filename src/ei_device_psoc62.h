@@ -61,8 +61,6 @@ private:
     ei_device_sensor_t sensors[sensors_count];
     EiState state;
 #ifndef FREERTOS_ENABLED /* bare-metal */
-    cyhal_timer_t sample_timer;
-    cyhal_timer_cfg_t sample_timer_cfg;
     cyhal_timer_t led_timer;
 #endif
     volatile bool environmental_sampling;
@@ -84,6 +82,8 @@ public:
     void set_environmental_sampling(void);
     void clear_environmental_sampling(void);
     bool is_environmental_sampling(void);
+    uint64_t get_sample_timestamp_us(void) override;
+    void print_sample_clock_stats(void);
 };
 
 #endif /* EI_DEVICE_PSOC62_H_ */
@@ -66,6 +66,8 @@ uint32_t EiFlashMemory::write_data(const uint8_t *data, uint32_t address, uint32
     uint32_t n_bytes = 0;
     uint32_t bytes_to_write = num_bytes;
 
+    wait_for_erase(address + num_bytes);
+
     do {
         if(bytes_to_write > FLASH_PAGE_SIZE) {
             n_bytes = FLASH_PAGE_SIZE;
@@ -77,8 +79,8 @@ uint32_t EiFlashMemory::write_data(const uint8_t *data, uint32_t address, uint32
         }
 
         /* If write overflows page, split up in 2 writes */
-        if((((address+offset) & 0x000000ff) + n_bytes) > FLASH_PAGE_SIZE) {
-            int diff = FLASH_PAGE_SIZE - ((address+offset) & 0xFF);
+        if((((address+offset) & (FLASH_PAGE_SIZE - 1)) + n_bytes) > FLASH_PAGE_SIZE) {
+            int diff = FLASH_PAGE_SIZE - ((address+offset) & (FLASH_PAGE_SIZE - 1));
 
             result = cy_serial_flash_qspi_write(address + offset, diff, ((uint8_t *)data + offset));
             if(result != CY_RSLT_SUCCESS) {
@@ -133,6 +135,114 @@ uint32_t EiFlashMemory::erase_data(uint32_t address, uint32_t num_bytes)
     return num_bytes;
 }
 
+/******
+ *
+ * @brief Erase-ahead. Before sampling only FLASH_ERASE_SYNC_SECTORS are erased,
+ *        the rest of the sample region is erased by a background task, which keeps
+ *        FLASH_ERASE_AHEAD_SECTORS erased in front of the write pointer.
+ *        If the writer catches up, the write waits for the erase and it is counted as a stall.
+ *
+ ******/
+
+#ifdef FREERTOS_ENABLED
+void EiFlashMemory::erase_ahead_task(void *arg)
+{
+    EiFlashMemory *mem = static_cast<EiFlashMemory*>(arg);
+
+    while(1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        mem->erase_busy = true;
+        while(mem->erased_until < mem->erase_end &&
+              mem->erased_until < mem->write_pointer + FLASH_ERASE_AHEAD_SECTORS * mem->block_size) {
+            if(mem->erase_data(mem->erased_until, mem->block_size) != mem->block_size) {
+                ei_printf("ERR: Failed to erase flash at 0x%08lx\n", mem->erased_until);
+                /* give up, writes to the rest of the region won't wait anymore */
+                mem->erase_end = mem->erased_until;
+                break;
+            }
+            mem->erased_until += mem->block_size;
+        }
+        mem->erase_busy = false;
+    }
+}
+#endif
+
+void EiFlashMemory::wait_for_erase(uint32_t end_address)
+{
+#ifdef FREERTOS_ENABLED
+    if(this->erased_until >= this->erase_end) {
+        /* nothing scheduled */
+        return;
+    }
+
+    if(end_address > this->write_pointer) {
+        this->write_pointer = end_address;
+        xTaskNotifyGive(this->erase_task);
+    }
+
+    if(end_address > this->erased_until) {
+        this->erase_stalls++;
+        while(end_address > this->erased_until && this->erased_until < this->erase_end) {
+            ei_sleep(1);
+        }
+    }
+#endif
+}
+
+void EiFlashMemory::stop_erase_ahead(void)
+{
+    this->erase_end = this->erased_until;
+
+    while(this->erase_busy) {
+        ei_sleep(1);
+    }
+}
+
+uint32_t EiFlashMemory::erase_sample_data_ahead(uint32_t address, uint32_t num_bytes)
+{
+    uint32_t start = this->used_blocks * this->block_size + address;
+    uint32_t sync_bytes = FLASH_ERASE_SYNC_SECTORS * this->block_size;
+
+    if(this->page_cache_fill != 0) {
+        flush_data();
+    }
+    stop_erase_ahead();
+
+#ifdef FREERTOS_ENABLED
+    if(num_bytes > sync_bytes && this->erase_task != NULL) {
+        if(erase_data(start, sync_bytes) != sync_bytes) {
+            return 0;
+        }
+
+        this->erase_stalls = 0;
+        this->write_pointer = start;
+        this->erased_until = start + sync_bytes;
+        this->erase_end = start + num_bytes;
+        xTaskNotifyGive(this->erase_task);
+
+        return num_bytes;
+    }
+#endif
+
+    return erase_data(start, num_bytes);
+}
+
+void EiFlashMemory::finalize_samplig(void)
+{
+    EiDeviceMemory::finalize_samplig();
+    stop_erase_ahead();
+
+    if(this->erase_stalls != 0) {
+        ei_printf("WARN: sample writes waited for flash erase %lu times\n", this->erase_stalls);
+    }
+}
+
+uint32_t EiFlashMemory::get_erase_stalls(void)
+{
+    return this->erase_stalls;
+}
+
 EiFlashMemory::EiFlashMemory(uint32_t config_size):
     EiDeviceMemory(config_size, FLASH_ERASE_TIME, FLASH_SIZE, FLASH_SECTOR_SIZE)
 {
@@ -143,4 +253,19 @@ EiFlashMemory::EiFlashMemory(uint32_t config_size):
 				NC, NC, NC, NC, CYBSP_QSPI_SCK, CYBSP_QSPI_SS,
 				QSPI_BUS_FREQUENCY_HZ);
 	CY_ASSERT(result == CY_RSLT_SUCCESS);
+
+    /* Samplers are writing a few bytes at a time, merge them into full
+     * program pages to avoid QSPI command overhead on every write.
+     */
+    enable_page_cache(page_buffer, FLASH_PAGE_SIZE);
+
+    erase_end = 0;
+    erased_until = 0;
+    write_pointer = 0;
+    erase_stalls = 0;
+    erase_busy = false;
+#ifdef FREERTOS_ENABLED
+    erase_task = xTaskCreateStatic(erase_ahead_task, "Flash eraser", FLASH_ERASE_TASK_STACK_SIZE,
+                                   this, FLASH_ERASE_TASK_PRIORITY, erase_task_stack, &erase_task_buffer);
+#endif
 }
@@ -37,6 +37,11 @@
 
 #include "firmware-sdk/ei_device_memory.h"
 
+#ifdef FREERTOS_ENABLED
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
 extern "C" {
 	#include "cy_pdl.h"
 	#include "cyhal.h"
@@ -56,7 +61,35 @@ extern "C" {
 #define FLASH_PAGE_SIZE     0x0200      // 512 Byte Page size
 #define FLASH_BLOCK_NUM     (FLASH_SIZE / SECTOR_SIZE)
 
+/*
+  Erase-ahead related defines
+*/
+#define FLASH_ERASE_SYNC_SECTORS    1       // sectors erased before sampling starts
+#define FLASH_ERASE_AHEAD_SECTORS   2       // sectors kept erased in front of the write pointer
+#define FLASH_ERASE_TASK_PRIORITY   (2u)
+#define FLASH_ERASE_TASK_STACK_SIZE (512u)  // in words
+
 class EiFlashMemory : public EiDeviceMemory {
+private:
+    /* Sample writes are collected here and programmed as whole pages */
+    uint8_t page_buffer[FLASH_PAGE_SIZE];
+
+    /* Erase-ahead state, all addresses are absolute */
+    volatile uint32_t erase_end;        /* end of the region scheduled for erase */
+    volatile uint32_t erased_until;     /* flash is erased up to this address */
+    volatile uint32_t write_pointer;    /* end of the last write */
+    volatile uint32_t erase_stalls;     /* how many times writes had to wait for erase */
+    volatile bool erase_busy;
+#ifdef FREERTOS_ENABLED
+    TaskHandle_t erase_task;
+    StaticTask_t erase_task_buffer;
+    StackType_t erase_task_stack[FLASH_ERASE_TASK_STACK_SIZE];
+
+    static void erase_ahead_task(void *arg);
+#endif
+    void wait_for_erase(uint32_t end_address);
+    void stop_erase_ahead(void);
+
 protected:
     uint32_t read_data(uint8_t *data, uint32_t address, uint32_t num_bytes);
     uint32_t write_data(const uint8_t *data, uint32_t address, uint32_t num_bytes);
@@ -64,6 +97,9 @@ protected:
 
 public:
     EiFlashMemory(uint32_t config_size);
+    uint32_t erase_sample_data_ahead(uint32_t address, uint32_t num_bytes) override;
+    void finalize_samplig(void) override;
+    uint32_t get_erase_stalls(void);
 };
 
 #endif /* EI_FLASH_MEMORY_H */
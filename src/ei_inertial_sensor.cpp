@@ -34,6 +34,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "cy_pdl.h"
 #include "cyhal.h"
@@ -51,6 +52,17 @@
 #define IMU_SCALING_CONST   (16384.0)
 #define I2C_CLK_FREQ_HZ     (1000000UL)
 
+/* FIFO mode: the IMU samples at its own ODR into its 1 KB FIFO. The FIFO is read in one burst
+ * every IMU_FIFO_BURST_MS (at most half full) into fifo_queue, which hands out one frame per tick,
+ * paced by the sensor time */
+#define IMU_FIFO_SIZE           1024
+#define IMU_FIFO_FRAME_SIZE     (1 + BMI160_FIFO_A_LENGTH) /* header + accel frame */
+#define IMU_FIFO_MAX_FRAMES     ((IMU_FIFO_SIZE / IMU_FIFO_FRAME_SIZE) + 1)
+#define IMU_FIFO_BURST_MS       100
+#define IMU_FIFO_QUEUE_SIZE     (IMU_FIFO_MAX_FRAMES + 8) /* a full FIFO plus frames left from the last burst */
+#define IMU_SENSOR_TIME_MASK    0xFFFFFFu /* 24 bit sensor time counter */
+#define IMU_SENSOR_TIME_US(t)   (((t) * 625u) / 16u) /* sensor time LSB is 39.0625 us */
+
 /***************************************
  *        Local variables
  **************************************/
@@ -59,6 +71,53 @@ static mtb_bmi160_data_t raw_data;
 static mtb_bmi160_t motion_sensor;
 static cyhal_i2c_t mI2C;
 
+typedef struct {
+    float hz;
+    uint8_t odr;
+} imu_odr_t;
+
+static const imu_odr_t imu_odr_table[] = {
+    { 12.5f, BMI160_ACCEL_ODR_12_5HZ },
+    { 25.0f, BMI160_ACCEL_ODR_25HZ },
+    { 50.0f, BMI160_ACCEL_ODR_50HZ },
+    { 100.0f, BMI160_ACCEL_ODR_100HZ },
+    { 200.0f, BMI160_ACCEL_ODR_200HZ },
+    { 400.0f, BMI160_ACCEL_ODR_400HZ },
+    { 800.0f, BMI160_ACCEL_ODR_800HZ },
+    { 1600.0f, BMI160_ACCEL_ODR_1600HZ },
+};
+
+static bool fifo_mode = false;
+static uint8_t fifo_buffer[IMU_FIFO_SIZE + BMI160_FIFO_BYTES_OVERREAD];
+static struct bmi160_fifo_frame fifo_frame;
+/* frames read from the FIFO, fifo_queue_head..fifo_queue_count are not handed out yet */
+static struct bmi160_sensor_data fifo_queue[IMU_FIFO_QUEUE_SIZE];
+static uint64_t fifo_queue_time_us[IMU_FIFO_QUEUE_SIZE];
+static uint16_t fifo_queue_head;
+static uint16_t fifo_queue_count;
+static uint16_t fifo_burst_ticks;       /* sample ticks between two FIFO reads */
+static uint16_t fifo_ticks_to_burst;
+static bool fifo_offset_valid;
+static int64_t fifo_offset_us;          /* sensor time minus sample tick time, set by the first frame */
+static uint8_t fifo_saved_odr;
+static uint32_t fifo_period_us;
+static bool fifo_time_valid;
+static uint32_t fifo_last_sensor_time;  /* raw 24 bit sensor time of the last FIFO read */
+static uint64_t fifo_sensor_ticks;      /* the same, without wrap around */
+static uint64_t fifo_newest_time_us;    /* sensor time of the newest frame read */
+
+typedef struct {
+    uint32_t delivered;     /* ticks that got a new frame */
+    uint32_t underruns;     /* ticks that repeated the last frame, IMU slower than the sample timer */
+    uint32_t dropped;       /* frames dropped, IMU faster than the sample timer */
+    uint32_t skipped;       /* frames lost on FIFO overflow */
+    uint64_t first_frame_us;
+    uint64_t first_tick_us;
+    uint64_t last_frame_us;
+    uint64_t last_tick_us;
+} fifo_stats_t;
+
+static fifo_stats_t fifo_stats;
 
 bool ei_inertial_sensor_init(void)
 {
@@ -116,11 +175,248 @@ bool ei_inertial_sensor_test(void)
     return ret;
 }
 
+/**
+ * @brief Switch the IMU to FIFO mode, if the sample interval matches one of the
+ *        accelerometer output data rates. Otherwise the IMU keeps being read on every sample.
+ * @return true if FIFO mode is active
+ */
+bool ei_inertial_sensor_fifo_start(float sample_interval_ms)
+{
+    struct bmi160_dev *sensor = mtb_bmi160_get(&motion_sensor);
+    float frequency = 1000.0f / sample_interval_ms;
+    const imu_odr_t *odr = NULL;
+    int8_t rslt;
+
+    for(size_t i = 0; i < sizeof(imu_odr_table) / sizeof(imu_odr_table[0]); i++) {
+        if(imu_odr_table[i].hz > frequency - 0.01f && imu_odr_table[i].hz < frequency + 0.01f) {
+            odr = &imu_odr_table[i];
+            break;
+        }
+    }
+
+    if(odr == NULL) {
+        return false;
+    }
+
+    fifo_saved_odr = sensor->accel_cfg.odr;
+    sensor->accel_cfg.odr = odr->odr;
+    sensor->fifo = &fifo_frame;
+    fifo_frame.data = fifo_buffer;
+
+    rslt = bmi160_set_sens_conf(sensor);
+    if(rslt == BMI160_OK) {
+        rslt = bmi160_set_fifo_config(BMI160_FIFO_ACCEL | BMI160_FIFO_HEADER | BMI160_FIFO_TIME, BMI160_ENABLE, sensor);
+    }
+    if(rslt == BMI160_OK) {
+        rslt = bmi160_set_fifo_flush(sensor);
+    }
+
+    if(rslt != BMI160_OK) {
+        ei_printf("ERR: IMU FIFO config failed (%d), reading samples one by one\n", rslt);
+        bmi160_set_fifo_config(BMI160_FIFO_ACCEL | BMI160_FIFO_HEADER | BMI160_FIFO_TIME, BMI160_DISABLE, sensor);
+        sensor->accel_cfg.odr = fifo_saved_odr;
+        bmi160_set_sens_conf(sensor);
+        return false;
+    }
+
+    fifo_period_us = (uint32_t)(sample_interval_ms * 1000.0f);
+    fifo_burst_ticks = (uint16_t)((IMU_FIFO_BURST_MS * 1000u) / fifo_period_us);
+    if(fifo_burst_ticks > IMU_FIFO_MAX_FRAMES / 2) {
+        fifo_burst_ticks = IMU_FIFO_MAX_FRAMES / 2;
+    }
+    if(fifo_burst_ticks == 0) {
+        fifo_burst_ticks = 1;
+    }
+    fifo_ticks_to_burst = 0;
+    fifo_queue_head = 0;
+    fifo_queue_count = 0;
+    fifo_offset_valid = false;
+    fifo_time_valid = false;
+    fifo_sensor_ticks = 0;
+    fifo_newest_time_us = 0;
+    memset(&fifo_stats, 0, sizeof(fifo_stats));
+
+    /* let the IMU put its first frame in the FIFO before the first sample tick */
+    ei_sleep((uint32_t)sample_interval_ms + 1);
+
+    fifo_mode = true;
+
+    return true;
+}
+
+/**
+ * @brief Leave FIFO mode and restore the previous output data rate
+ */
+void ei_inertial_sensor_fifo_stop(void)
+{
+    struct bmi160_dev *sensor = mtb_bmi160_get(&motion_sensor);
+
+    if(fifo_mode == false) {
+        return;
+    }
+
+    fifo_mode = false;
+
+    bmi160_set_fifo_config(BMI160_FIFO_ACCEL | BMI160_FIFO_HEADER | BMI160_FIFO_TIME, BMI160_DISABLE, sensor);
+    sensor->accel_cfg.odr = fifo_saved_odr;
+    bmi160_set_sens_conf(sensor);
+
+    if(fifo_stats.underruns > 0 || fifo_stats.skipped > 0) {
+        ei_printf("WARN: IMU FIFO underruns: %lu, frames lost on FIFO overflow: %lu\n",
+            fifo_stats.underruns, fifo_stats.skipped);
+    }
+}
+
+/**
+ * @brief Print how the IMU output data rate and the sample timer were reconciled
+ *        in the last (or running) FIFO mode sampling
+ */
+void ei_inertial_sensor_print_fifo_stats(void)
+{
+    uint64_t frame_us = fifo_stats.last_frame_us - fifo_stats.first_frame_us;
+    uint64_t tick_us = fifo_stats.last_tick_us - fifo_stats.first_tick_us;
+
+    if(fifo_stats.delivered == 0 && fifo_stats.underruns == 0) {
+        return;
+    }
+
+    ei_printf("IMU FIFO: delivered: %lu, repeated: %lu, dropped: %lu, lost on overflow: %lu\n",
+        fifo_stats.delivered, fifo_stats.underruns, fifo_stats.dropped, fifo_stats.skipped);
+    if(tick_us > 0) {
+        /* sensor time passed per sample timer time, i.e. how much faster the IMU runs */
+        ei_printf("IMU ODR vs sample timer: %ld ppm\n",
+            (long)(((double)frame_us / (double)tick_us - 1.0) * 1000000.0));
+    }
+}
+
+/**
+ * @brief Accelerometer m/s2 per raw BMI160 count (2 g range), to get the counts back
+ *        from the samples returned by ei_fusion_inertial_sensor_read_data
+ */
+float ei_inertial_sensor_units_per_count(void)
+{
+    return (float)(CONVERT_G_TO_MS2 / IMU_SCALING_CONST);
+}
+
+/**
+ * @brief Move everything the IMU has put in its FIFO since the last burst to fifo_queue
+ */
+static void fifo_drain(void)
+{
+    struct bmi160_dev *sensor = mtb_bmi160_get(&motion_sensor);
+
+    /* frames left from the last burst go to the front */
+    fifo_queue_count -= fifo_queue_head;
+    memmove(&fifo_queue[0], &fifo_queue[fifo_queue_head], fifo_queue_count * sizeof(fifo_queue[0]));
+    memmove(&fifo_queue_time_us[0], &fifo_queue_time_us[fifo_queue_head], fifo_queue_count * sizeof(fifo_queue_time_us[0]));
+    fifo_queue_head = 0;
+
+    uint8_t frames = IMU_FIFO_QUEUE_SIZE - fifo_queue_count;
+
+    fifo_frame.length = sizeof(fifo_buffer);
+
+    int8_t rslt = bmi160_get_fifo_data(sensor);
+    if(rslt == BMI160_OK) {
+        rslt = bmi160_extract_accel(&fifo_queue[fifo_queue_count], &frames, sensor);
+    }
+
+    if(rslt != BMI160_OK) {
+        ei_printf("ERR: IMU FIFO read failed (%d)\n", rslt);
+        return;
+    }
+
+    fifo_stats.skipped += fifo_frame.skipped_frame_count;
+
+    if(frames == 0) {
+        return;
+    }
+
+    /* sensor time of the last frame is appended when the FIFO is read empty (0 if it isn't) */
+    if(fifo_frame.sensor_time != 0) {
+        if(fifo_time_valid) {
+            fifo_sensor_ticks += (fifo_frame.sensor_time - fifo_last_sensor_time) & IMU_SENSOR_TIME_MASK;
+        }
+        else {
+            fifo_sensor_ticks = fifo_frame.sensor_time;
+            fifo_time_valid = true;
+        }
+        fifo_last_sensor_time = fifo_frame.sensor_time;
+        fifo_newest_time_us = IMU_SENSOR_TIME_US(fifo_sensor_ticks);
+    }
+    else {
+        fifo_newest_time_us += (uint64_t)frames * fifo_period_us;
+    }
+
+    for(uint8_t i = 0; i < frames; i++) {
+        fifo_queue_time_us[fifo_queue_count + i] = fifo_newest_time_us - (uint64_t)(frames - 1 - i) * fifo_period_us;
+    }
+    fifo_queue_count += frames;
+}
+
+/**
+ * @brief Hand out the frame for the current sample tick. The FIFO is only read every
+ *        fifo_burst_ticks ticks, or earlier if the queue runs empty. The tick time is mapped
+ *        to sensor time with the offset of the first frame. Frames more than half a period
+ *        older than the tick are dropped (IMU faster than the sample timer), if the oldest
+ *        frame is more than half a period newer the last frame is repeated (IMU slower).
+ */
+static void fifo_read_frame(void)
+{
+    uint64_t tick_us = ei_fusion_get_sample_timestamp_us();
+    uint64_t half_period_us = fifo_period_us / 2;
+
+    if(fifo_ticks_to_burst == 0 || fifo_queue_head == fifo_queue_count) {
+        fifo_drain();
+        fifo_ticks_to_burst = fifo_burst_ticks;
+    }
+    fifo_ticks_to_burst--;
+
+    if(fifo_queue_head == fifo_queue_count) {
+        fifo_stats.underruns++;
+        return;
+    }
+
+    if(!fifo_offset_valid) {
+        fifo_offset_us = (int64_t)fifo_queue_time_us[fifo_queue_head] - (int64_t)tick_us;
+        fifo_offset_valid = true;
+    }
+    uint64_t expected_us = (uint64_t)((int64_t)tick_us + fifo_offset_us);
+
+    while(fifo_queue_head < fifo_queue_count - 1 && fifo_queue_time_us[fifo_queue_head] + half_period_us < expected_us) {
+        fifo_queue_head++;
+        fifo_stats.dropped++;
+    }
+
+    if(fifo_queue_time_us[fifo_queue_head] > expected_us + half_period_us) {
+        fifo_stats.underruns++;
+        return;
+    }
+
+    struct bmi160_sensor_data *frame = &fifo_queue[fifo_queue_head];
+    imu_data[0] = (frame->x / IMU_SCALING_CONST) * CONVERT_G_TO_MS2;
+    imu_data[1] = (frame->y / IMU_SCALING_CONST) * CONVERT_G_TO_MS2;
+    imu_data[2] = (frame->z / IMU_SCALING_CONST) * CONVERT_G_TO_MS2;
+
+    fifo_stats.last_frame_us = fifo_queue_time_us[fifo_queue_head];
+    fifo_stats.last_tick_us = tick_us;
+    if(fifo_stats.delivered++ == 0) {
+        fifo_stats.first_frame_us = fifo_stats.last_frame_us;
+        fifo_stats.first_tick_us = fifo_stats.last_tick_us;
+    }
+
+    fifo_queue_head++;
+}
+
 float *ei_fusion_inertial_sensor_read_data(int n_samples)
 {
     cy_rslt_t result;
     float temp_data[INERTIAL_AXIS_SAMPLED];
 
+    if(fifo_mode) {
+        fifo_read_frame();
+        return imu_data;
+    }
+
     result = mtb_bmi160_read(&motion_sensor, &raw_data);
 
     if(result == CY_RSLT_SUCCESS) {
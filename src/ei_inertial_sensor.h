@@ -45,6 +45,10 @@
 bool ei_inertial_sensor_init(void);
 bool ei_inertial_sensor_test(void);
 float *ei_fusion_inertial_sensor_read_data(int n_samples);
+bool ei_inertial_sensor_fifo_start(float sample_interval_ms);
+void ei_inertial_sensor_fifo_stop(void);
+void ei_inertial_sensor_print_fifo_stats(void);
+float ei_inertial_sensor_units_per_count(void);
 
 static const ei_device_fusion_sensor_t inertial_sensor = {
     // name of sensor module to be displayed in fusion list
@@ -36,6 +36,7 @@
 #include "edge-impulse-sdk/dsp/numpy.hpp"
 #include "firmware-sdk/sensor-aq/sensor_aq.h"
 #include "ei_device_psoc62.h"
+#include "ei_flash_memory.h"
 #include "ei_microphone.h"
 #include "firmware-sdk/sensor-aq/sensor_aq_none.h"
 #include "sensor_aq_mbedtls_hs256.h"
@@ -46,6 +47,12 @@
 #include "cyhal_pdmpcm.h"
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef FREERTOS_ENABLED
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
 
 /* AUDIO SYSTEM CONSTANTS */
 /* Audio Subsystem Clock. Typical values depends on the desire sample rate:
@@ -63,15 +70,25 @@
 /* Microphone takes about 100ms settling time */
 #define MICROPHONE_SETTLE_TIME 300 /* triple this to be safe */
 
-/* Size of the ping-pong buffers in bytes (allocated on stack).
- * Must by multiple of sizeof(microphone_sample_t) and multiple of 2.
- * Using ping-pong buffers enables us to write one buffer to flash,
- * while sampling in the other.
+/* Number and size (in bytes) of the ingestion buffers.
+ * Size must by multiple of sizeof(microphone_sample_t) and multiple of 2.
+ * The PDM fills one buffer while the writer task stores the others to flash.
+ * The erase-ahead task holds the flash for a whole sector erase (FLASH_ERASE_TIME),
+ * so at the highest sample rate the ring covers one erase, plus the buffer the writer
+ * holds when the erase starts and the buffer the PDM fills.
  */
-#define TOTAL_BUFFER_SIZE       (32000U)
-#define TOTAL_BUFFER_SAMPLES    (TOTAL_BUFFER_SIZE / sizeof(microphone_sample_t))
-#define SINGLE_BUFFER_SIZE      (TOTAL_BUFFER_SIZE / 2)
+#define INGESTION_MAX_SAMPLE_RATE_HZ    (32000U)
+#define SINGLE_BUFFER_SIZE      (8000U)
 #define SINGLE_BUFFER_SAMPLES   (SINGLE_BUFFER_SIZE / sizeof(microphone_sample_t))
+#define INGESTION_ERASE_BYTES   ((FLASH_ERASE_TIME * INGESTION_MAX_SAMPLE_RATE_HZ / 1000U) * sizeof(microphone_sample_t))
+#define INGESTION_BUFFERS       (((INGESTION_ERASE_BYTES + SINGLE_BUFFER_SIZE - 1) / SINGLE_BUFFER_SIZE) + 2U)
+
+/* Writer task, higher priority than the EI task so flash writes are not delayed by it */
+#define MIC_WRITER_TASK_PRIORITY    (3u)
+#define MIC_WRITER_TASK_STACK_SIZE  (512u)
+/* Notification index the writer uses to signal the sampling task that all buffers are in flash.
+ * Not the default index 0, which wakes ei_sched_idle() and the other waits of the same task. */
+#define MIC_DONE_NOTIFY_INDEX       (1u)
 
 /* LOCAL VARIABLES */
 static cyhal_clock_t audio_clock;
@@ -88,13 +105,20 @@ static cyhal_pdm_pcm_cfg_t pdm_pcm_cfg = {
 };
 
 /* Sampling related variables */
-static volatile bool pdm_pcm_flag = false;
-static int16_t *readyBuffer;
-static int16_t bufOne[SINGLE_BUFFER_SIZE];
-static int16_t bufTwo[SINGLE_BUFFER_SIZE];
+static microphone_sample_t ingestion_buffers[INGESTION_BUFFERS][SINGLE_BUFFER_SAMPLES];
+static volatile uint32_t buffers_filled;    /* written by the PDM ISR only */
+static volatile uint32_t buffers_written;   /* written by the writer only */
+static volatile uint32_t buffer_overruns;
+static uint32_t ingestion_required_bytes;
+#ifdef FREERTOS_ENABLED
+static TaskHandle_t mic_writer_task;
+static StaticTask_t mic_writer_task_buffer;
+static StackType_t mic_writer_task_stack[MIC_WRITER_TASK_STACK_SIZE];
+static TaskHandle_t mic_sampler_task;
+#endif
 /* CBOR variables */
 static uint32_t headerOffset;
-static uint32_t collected_bytes;
+static volatile uint32_t collected_bytes;
 
 /* Inference variables */
 /** Status and control struct for inferencing struct */
@@ -104,6 +128,7 @@ typedef struct {
     uint8_t buf_ready;
     uint32_t buf_count;
     uint32_t n_samples;
+    bool running;
 } inference_t;
 static inference_t inference;
 
@@ -184,48 +209,69 @@ static bool pdm_configure(uint32_t sample_rate, cyhal_pdm_pcm_event_callback_t p
     return true;
 }
 
+/**
+ * @brief Buffer N is always ingestion_buffers[N % INGESTION_BUFFERS]. Sampling was started
+ *        on buffer 0 in ei_microphone_sample_start. When a buffer is complete, it is handed
+ *        to the writer and the next one is filled. If the writer still holds all other
+ *        buffers, the completed buffer is dropped and refilled, and it is counted as overrun.
+ */
 void ingestion_isr_handler(void *arg, cyhal_pdm_pcm_event_t event)
 {
-    static bool ping_pong = false;
-
-    /* Sampling was started in ei_microphone_sample_start on bufOne,
-     * therefore first time we hit our ping_pong scheme, we need to
-     * set readyBuffer point to bufone and start sampling with bufTwo.
-     *
-     */
-    if(ping_pong)
-    {
-        /* Write next frame to ping buffer */
-        cyhal_pdm_pcm_read_async(&pdm_pcm, bufOne, SINGLE_BUFFER_SAMPLES);
-        /* Setup the pong buffer to be read */
-        readyBuffer = bufTwo;
+    uint32_t filled = buffers_filled;
+
+    if(filled + 1 - buffers_written < INGESTION_BUFFERS) {
+        filled++;
+        buffers_filled = filled;
     }
-    else
-    {
-        /* Write next frame to pong buffer */
-        cyhal_pdm_pcm_read_async(&pdm_pcm, bufTwo, SINGLE_BUFFER_SAMPLES);
-        /* Setup the ping buffer to be read */
-        readyBuffer = bufOne;
+    else {
+        buffer_overruns++;
     }
 
-    ping_pong = !ping_pong;
-    pdm_pcm_flag = true;
+    cyhal_pdm_pcm_read_async(&pdm_pcm, ingestion_buffers[filled % INGESTION_BUFFERS], SINGLE_BUFFER_SAMPLES);
+
+#ifdef FREERTOS_ENABLED
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(mic_writer_task, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+#endif
 }
 
 /****************************** INGESTION RELATED FUNCTIONS *************************************************/
 
-static void ingestion_process(uint32_t n_bytes)
+/**
+ * @brief Write all completed buffers to flash
+ * @return true when all required bytes are collected
+ */
+static bool ingestion_process(void)
 {
     EiDevicePSoC62* dev = static_cast<EiDevicePSoC62*>(EiDevicePSoC62::get_device());
     EiDeviceMemory* mem = dev->get_memory();
 
-    if(readyBuffer != NULL) {
-        mem->write_sample_data((const uint8_t *)readyBuffer, headerOffset + collected_bytes, n_bytes);
+    while(buffers_written != buffers_filled && collected_bytes < ingestion_required_bytes) {
+        const microphone_sample_t *buffer = ingestion_buffers[buffers_written % INGESTION_BUFFERS];
+
+        mem->write_sample_data((const uint8_t *)buffer, headerOffset + collected_bytes, SINGLE_BUFFER_SIZE);
+
+        collected_bytes += SINGLE_BUFFER_SIZE;
+        buffers_written = buffers_written + 1;
     }
 
-    collected_bytes += n_bytes;
+    return collected_bytes >= ingestion_required_bytes;
 }
 
+#ifdef FREERTOS_ENABLED
+static void ingestion_writer_task(void *arg)
+{
+    while(1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if(ingestion_process()) {
+            xTaskNotifyGiveIndexed(mic_sampler_task, MIC_DONE_NOTIFY_INDEX);
+        }
+    }
+}
+#endif
+
 static int insert_ref(char *buffer, int hdrLength)
 {
     #define EXTRA_BYTES(a)  ((a & 0x3) ? 4 - (a & 0x3) : (a & 0x03))
@@ -325,64 +371,92 @@ bool ei_microphone_sample_start(void)
 
     required_bytes = required_samples * sizeof(microphone_sample_t);
     collected_bytes = 0;
+    buffers_filled = 0;
+    buffers_written = 0;
+    buffer_overruns = 0;
+
+    uint32_t sample_rate = (uint32_t)(1000.f / dev->get_sample_interval_ms());
 
     if(required_bytes > mem->get_available_sample_bytes()) {
-        ei_printf("ERR: Sample length is too long. Maximum allowed is %lu ms at 16000 Hz.\r\n", 
-            ((mem->get_available_sample_bytes() / (16000 * sizeof(microphone_sample_t))) * 1000));
+        ei_printf("ERR: Sample length is too long. Maximum allowed is %lu ms at %lu Hz.\r\n",
+            ((mem->get_available_sample_bytes() / (sample_rate * sizeof(microphone_sample_t))) * 1000), sample_rate);
         return false;
     }
 
-    dev->set_state(eiStateErasingFlash);
+    ingestion_required_bytes = required_bytes;
 
-    // Minimum delay of 2000 ms for daemon
-    uint32_t delay_time_ms = ((required_bytes / mem->block_size) + 1) * mem->block_erase_time;
-    ei_printf("Starting in %lu ms... (or until all flash was erased)\n", delay_time_ms < 2000 ? 2000 : delay_time_ms);
+#ifdef FREERTOS_ENABLED
+    mic_sampler_task = xTaskGetCurrentTaskHandle();
+    if(mic_writer_task == NULL) {
+        mic_writer_task = xTaskCreateStatic(ingestion_writer_task, "Mic writer", MIC_WRITER_TASK_STACK_SIZE,
+                                            NULL, MIC_WRITER_TASK_PRIORITY, mic_writer_task_stack, &mic_writer_task_buffer);
+    }
+    // drop a stale notification from a previous run
+    ulTaskNotifyTakeIndexed(MIC_DONE_NOTIFY_INDEX, pdTRUE, 0);
+#endif
 
-    if(mem->erase_sample_data(0, required_bytes) != (required_bytes)) {
+    dev->set_state(eiStateErasingFlash);
+
+    // only the beginning of the region is erased here, the rest is erased while sampling
+    uint64_t erase_start_ms = ei_read_timer_ms();
+    if(mem->erase_sample_data_ahead(0, required_bytes) != (required_bytes)) {
         return false;
     }
 
+    // Minimum delay of 2000 ms for daemon
+    uint32_t erase_time_ms = (uint32_t)(ei_read_timer_ms() - erase_start_ms);
+    uint32_t delay_time_ms = erase_time_ms < 2000 ? 2000 - erase_time_ms : 0;
+    ei_printf("Starting in %lu ms... (or until all flash was erased)\n", delay_time_ms);
+
     // if erasing took less than 2 seconds, wait additional time
-    if(delay_time_ms < 2000) {
-        ei_sleep(2000 - delay_time_ms);
+    if(delay_time_ms > 0) {
+        ei_sleep(delay_time_ms);
     }
 
-    pdm_configure((uint32_t)(1000.f / dev->get_sample_interval_ms()), ingestion_isr_handler);
+    pdm_configure(sample_rate, ingestion_isr_handler);
 
     create_header();
 
     // discard first mic data, because it takes about 100ms for the mic to settle
-    cyhal_pdm_pcm_read_async(&pdm_pcm, bufOne, SINGLE_BUFFER_SAMPLES);
+    cyhal_pdm_pcm_read_async(&pdm_pcm, ingestion_buffers[0], SINGLE_BUFFER_SAMPLES);
     ei_sleep(MICROPHONE_SETTLE_TIME);
     cyhal_pdm_pcm_abort_async(&pdm_pcm);
     // enable PDM async sampling
     cyhal_pdm_pcm_enable_event(&pdm_pcm, CYHAL_PDM_PCM_ASYNC_COMPLETE, CYHAL_ISR_PRIORITY_DEFAULT, true);
     // now start normal data collection
-    result = cyhal_pdm_pcm_read_async(&pdm_pcm, bufOne, SINGLE_BUFFER_SAMPLES);
+    result = cyhal_pdm_pcm_read_async(&pdm_pcm, ingestion_buffers[0], SINGLE_BUFFER_SAMPLES);
     if(result != CY_RSLT_SUCCESS) {
         ei_printf("ERR: no audio data!\n");
     }
 
     ei_printf("Sampling...\n");
-    pdm_pcm_flag = false;
     dev->set_state(eiStateSampling);
 
-    while (collected_bytes < required_bytes) {
-        if(pdm_pcm_flag) {
-            pdm_pcm_flag = false;
-            ingestion_process(SINGLE_BUFFER_SIZE);
-        }
+#ifdef FREERTOS_ENABLED
+    // writer task notifies us when all buffers are in flash
+    while(collected_bytes < required_bytes) {
+        ulTaskNotifyTakeIndexed(MIC_DONE_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
     }
+#else
+    while(!ingestion_process()) {
+    }
+#endif
 
     cyhal_pdm_pcm_abort_async(&pdm_pcm);
     cyhal_pdm_pcm_stop(&pdm_pcm);
     cyhal_pdm_pcm_free(&pdm_pcm);
+    mem->finalize_samplig();
 
     // we collect multiply of SINGLE_BUFFER_SAMPLES, if user requested less we have to adjust collected_bytes
     if(collected_bytes > required_bytes) {
         collected_bytes = required_bytes;
     }
 
+    if(buffer_overruns > 0) {
+        ei_printf("WARN: %lu audio buffers (%lu samples) dropped, flash writes too slow\n",
+            buffer_overruns, buffer_overruns * SINGLE_BUFFER_SAMPLES);
+    }
+
     ei_printf("Done sampling, total bytes collected: %lu\n", collected_bytes);
     ei_printf("[1/1] Uploading file to Edge Impulse...\n");
     ei_printf("Not uploading file, not connected to WiFi. Used buffer, from=0, to=%lu.\n", collected_bytes + headerOffset);
@@ -414,6 +488,18 @@ int ei_microphone_inference_get_data(size_t offset, size_t length, float *out_pt
     return ei::numpy::int16_to_float(&inference.buffers[inference.buf_select ^ 1][offset], out_ptr, length);
 }
 
+/**
+ * @brief signal_i16_t::get_data, the PDM samples as they are, for the fixed point MFE
+ */
+int ei_microphone_inference_get_data_i16(size_t offset, size_t length, int16_t *out_ptr)
+{
+    inference.buf_ready = 0;
+
+    memcpy(out_ptr, &inference.buffers[inference.buf_select ^ 1][offset], length * sizeof(int16_t));
+
+    return 0;
+}
+
 bool ei_microphone_inference_start(uint32_t n_samples, float interval_ms)
 {
     EiDevicePSoC62* dev = static_cast<EiDevicePSoC62*>(EiDevicePSoC62::get_device());
@@ -437,6 +523,7 @@ bool ei_microphone_inference_start(uint32_t n_samples, float interval_ms)
     inference.buf_count  = 0;
     inference.n_samples  = n_samples;
     inference.buf_ready  = 0;
+    inference.running    = false;
 
     pdm_configure((uint32_t)(1000.0f / dev->get_sample_interval_ms()), inference_isr_handler);
     cyhal_pdm_pcm_enable_event(&pdm_pcm, CYHAL_PDM_PCM_ASYNC_COMPLETE, CYHAL_ISR_PRIORITY_DEFAULT, true);
@@ -446,6 +533,58 @@ bool ei_microphone_inference_start(uint32_t n_samples, float interval_ms)
         ei_printf("ERR: no audio data!\n");
         return false;
     }
+    inference.running = true;
+
+    return true;
+}
+
+/**
+ * @brief Stop the PDM and keep the inference buffers, the last complete buffer can still be read.
+ *        Without a running PDM the CPU can go to deep sleep (scheduled inference).
+ */
+bool ei_microphone_inference_pause(void)
+{
+    if(inference.running) {
+        cyhal_pdm_pcm_abort_async(&pdm_pcm);
+        cyhal_pdm_pcm_stop(&pdm_pcm);
+        cyhal_pdm_pcm_free(&pdm_pcm);
+        inference.running = false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Restart the PDM after ei_microphone_inference_pause() and record a new buffer.
+ *        The samples taken while the microphone settles are discarded.
+ */
+bool ei_microphone_inference_resume(void)
+{
+    EiDevicePSoC62* dev = static_cast<EiDevicePSoC62*>(EiDevicePSoC62::get_device());
+    microphone_sample_t *buffer = inference.buffers[inference.buf_select];
+    cy_rslt_t result;
+
+    if(inference.running) {
+        return true;
+    }
+
+    if(pdm_configure((uint32_t)(1000.0f / dev->get_sample_interval_ms()), inference_isr_handler) == false) {
+        return false;
+    }
+    inference.running = true;
+
+    // discard first mic data, because it takes about 100ms for the mic to settle
+    cyhal_pdm_pcm_read_async(&pdm_pcm, buffer, inference.n_samples);
+    ei_sleep(MICROPHONE_SETTLE_TIME);
+    cyhal_pdm_pcm_abort_async(&pdm_pcm);
+
+    inference.buf_ready = 0;
+    cyhal_pdm_pcm_enable_event(&pdm_pcm, CYHAL_PDM_PCM_ASYNC_COMPLETE, CYHAL_ISR_PRIORITY_DEFAULT, true);
+    result = cyhal_pdm_pcm_read_async(&pdm_pcm, buffer, inference.n_samples);
+    if(result != CY_RSLT_SUCCESS) {
+        ei_printf("ERR: no audio data!\n");
+        return false;
+    }
 
     return true;
 }
@@ -463,9 +602,7 @@ void ei_microphone_inference_reset_buffers(void)
 
 bool ei_microphone_inference_end(void)
 {
-    cyhal_pdm_pcm_abort_async(&pdm_pcm);
-    cyhal_pdm_pcm_stop(&pdm_pcm);
-    cyhal_pdm_pcm_free(&pdm_pcm);
+    ei_microphone_inference_pause();
 
     ei_free(inference.buffers[0]);
     ei_free(inference.buffers[1]);
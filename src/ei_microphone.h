@@ -50,6 +50,9 @@ bool ei_microphone_inference_record(void);
 bool ei_microphone_inference_is_recording(void);
 void ei_microphone_inference_reset_buffers(void);
 int ei_microphone_inference_get_data(size_t offset, size_t length, float *out_ptr);
+int ei_microphone_inference_get_data_i16(size_t offset, size_t length, int16_t *out_ptr);
+bool ei_microphone_inference_pause(void);
+bool ei_microphone_inference_resume(void);
 bool ei_microphone_inference_end(void);
 
 #endif
@@ -40,6 +40,7 @@
 #include "ei_device_psoc62.h"
 #include "ei_microphone.h"
 #include "ei_run_impulse.h"
+#include "ei_run_scheduler.h"
 #include "cycfg_gatt_db.h"
 #include "ei_bluetooth_psoc63.h"
 
@@ -118,7 +119,21 @@ void ei_run_impulse(void)
             // nothing to do
             return;
         case INFERENCE_WAITING:
-            if (ei_read_timer_ms() < (last_inference_ts + 2000)) {
+            if (ei_sched_enabled() == true) {
+                if (ei_sched_time_to_window_ms() > 0) {
+                    // sleep until the window is due, a received char wakes us up early
+                    ei_sched_idle();
+                    return;
+                }
+                ei_sched_window_started();
+                // the microphone only runs for the window, so the CPU can deep sleep in between
+                if (ei_microphone_inference_resume() == false) {
+                    ei_printf("ERR: Failed to restart audio sampling\n");
+                    ei_stop_impulse();
+                    return;
+                }
+            }
+            else if (ei_read_timer_ms() < (last_inference_ts + 2000)) {
                 return;
             }
             ei_printf("Recording\n");
@@ -131,6 +146,10 @@ void ei_run_impulse(void)
             if (ei_microphone_inference_is_recording()) {
                 return;
             }
+            if (ei_sched_enabled() == true) {
+                // the window is recorded, the buffer stays readable
+                ei_microphone_inference_pause();
+            }
             inference_state = INFERENCE_DATA_READY;
             break;
             // nothing to do, just continue to inference provcessing below
@@ -139,6 +158,7 @@ void ei_run_impulse(void)
             break;
     }
 
+    uint64_t active_start_us = ei_read_timer_us();
     signal_t signal;
 
     signal.total_length = continuous_mode ? EI_CLASSIFIER_SLICE_SIZE : EI_CLASSIFIER_RAW_SAMPLE_COUNT;
@@ -151,7 +171,16 @@ void ei_run_impulse(void)
         ei_error = run_classifier_continuous(&signal, &result, debug_mode);
     }
     else {
+#if EIDSP_USE_Q15_MFE == 1
+        /* MFE blocks read the PDM samples as int16, without a float conversion */
+        signal_i16_t signal_i16;
+        signal_i16.total_length = signal.total_length;
+        signal_i16.get_data = &ei_microphone_inference_get_data_i16;
+        signal_i16.scale = 1.0f;
+        ei_error = run_classifier_i16(&signal_i16, &result, debug_mode);
+#else
         ei_error = run_classifier(&signal, &result, debug_mode);
+#endif
     }
     if (ei_error != EI_IMPULSE_OK) {
         ei_printf("Failed to run impulse (%d)", ei_error);
@@ -173,6 +202,11 @@ void ei_run_impulse(void)
     if (continuous_mode == true) {
         inference_state = INFERENCE_SAMPLING;
     }
+    else if (ei_sched_enabled() == true) {
+        ei_sched_add_active_us(ei_read_timer_us() - active_start_us);
+        ei_sched_print_stats();
+        inference_state = INFERENCE_WAITING;
+    }
     else {
         ei_printf("Starting inferencing in 2 seconds...\n");
         last_inference_ts = ei_read_timer_ms();
@@ -209,6 +243,10 @@ void ei_start_impulse(bool continuous, bool debug, bool use_max_uart_speed)
         run_classifier_init();
         inference_state = INFERENCE_SAMPLING;
     }
+    else if (ei_sched_enabled() == true) {
+        samples_per_inference = EI_CLASSIFIER_RAW_SAMPLE_COUNT * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+        inference_state = INFERENCE_WAITING;
+    }
     else {
         samples_per_inference = EI_CLASSIFIER_RAW_SAMPLE_COUNT * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
         // it's time to prepare for sampling
@@ -219,8 +257,37 @@ void ei_start_impulse(bool continuous, bool debug, bool use_max_uart_speed)
 
     if (ei_microphone_inference_start(continuous_mode ? EI_CLASSIFIER_SLICE_SIZE : EI_CLASSIFIER_RAW_SAMPLE_COUNT, EI_CLASSIFIER_INTERVAL_MS) == false) {
         ei_printf("ERR: Failed to setup audio sampling");
+        inference_state = INFERENCE_STOPPED;
+        return;
+    }
+
+    if (ei_sched_enabled() == true) {
+        // keep the buffers, the microphone is restarted for every window
+        ei_microphone_inference_pause();
+    }
+}
+
+void ei_start_impulse_scheduled(uint32_t period_ms, uint32_t window_ms, bool debug)
+{
+    const uint32_t model_window_ms = (uint32_t)(EI_CLASSIFIER_RAW_SAMPLE_COUNT * EI_CLASSIFIER_INTERVAL_MS);
+
+    // the microphone records exactly one model window
+    if (window_ms != model_window_ms) {
+        ei_printf("WARN: audio window is fixed by the model, using %lu ms\n", model_window_ms);
+        window_ms = model_window_ms;
+    }
+    if (period_ms < window_ms) {
+        ei_printf("ERR: period has to be at least %lu ms\n", window_ms);
+        return;
+    }
+
+    ei_sched_start(period_ms, window_ms);
+    ei_start_impulse(false, debug);
+    if (inference_state == INFERENCE_STOPPED) {
+        ei_sched_stop();
         return;
     }
+    ei_printf("Scheduled: %lu ms window every %lu ms\n", window_ms, period_ms);
 }
 
 void ei_stop_impulse(void)
@@ -234,6 +301,7 @@ void ei_stop_impulse(void)
         dev->set_state(eiStateFinished);
         run_classifier_deinit();
     }
+    ei_sched_stop();
 }
 
 bool is_inference_running(void)
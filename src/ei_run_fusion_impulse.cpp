@@ -38,29 +38,67 @@
             (EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_ACCELEROMETER))
 #include "edge-impulse-sdk/classifier/ei_run_classifier.h"
 #include "edge-impulse-sdk/classifier/ei_print_results.h"
-#include "edge-impulse-sdk/dsp/numpy.hpp"
 #include "firmware-sdk/ei_fusion.h"
 #include "ei_device_psoc62.h"
 #include "ei_run_impulse.h"
+#include "ei_run_scheduler.h"
 #include "cycfg_gatt_db.h"
 #include "ei_bluetooth_psoc63.h"
-
+#include "ei_inertial_sensor.h"
+
+
+/* room for one window being classified plus the samples collected meanwhile */
+#define SAMPLES_RING_SIZE   (2 * EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE)
+
+/* Gapless mode: AT+RUNIMPULSE keeps sampling between inferences (no 2 second pause)
+ * and classifies a window every EI_FUSION_INFERENCE_STRIDE samples (frames) */
+#ifndef EI_FUSION_GAPLESS_SAMPLING
+#define EI_FUSION_GAPLESS_SAMPLING  0
+#endif
+#ifndef EI_FUSION_INFERENCE_STRIDE
+#define EI_FUSION_INFERENCE_STRIDE  EI_CLASSIFIER_RAW_SAMPLE_COUNT
+#endif
+#if (EI_FUSION_INFERENCE_STRIDE < 1) || (EI_FUSION_INFERENCE_STRIDE > EI_CLASSIFIER_RAW_SAMPLE_COUNT)
+#error "EI_FUSION_INFERENCE_STRIDE has to be between 1 and EI_CLASSIFIER_RAW_SAMPLE_COUNT"
+#endif
+
+/* With the fixed point spectral analysis the ring keeps the raw BMI160 counts (half the RAM),
+ * which run_classifier_i16() hands to the DSP without converting them */
+#if (EIDSP_USE_Q15_SPECTRAL == 1) && (EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_ACCELEROMETER)
+#define SAMPLES_RING_COUNTS 1
+typedef int16_t ring_sample_t;
+#else
+#define SAMPLES_RING_COUNTS 0
+typedef float ring_sample_t;
+#endif
 
 typedef enum {
     INFERENCE_STOPPED,
     INFERENCE_WAITING,
-    INFERENCE_SAMPLING,
-    INFERENCE_DATA_READY
+    INFERENCE_SAMPLING
 } inference_state_t;
 
 static int print_results;
 static uint16_t samples_per_inference;
-static inference_state_t state = INFERENCE_STOPPED;
+static volatile inference_state_t state = INFERENCE_STOPPED;
 static uint64_t last_inference_ts = 0;
 static bool continuous_mode = false;
 static bool debug_mode = false;
-static float samples_circ_buff[EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE];
-static int samples_wr_index = 0;
+static bool gapless_mode = false;
+
+/* Single producer (sampler callback), single consumer (ei_run_impulse) ring.
+ * Positions count values since the sampling start, the buffer index is position % SAMPLES_RING_SIZE */
+static ring_sample_t samples_ring[SAMPLES_RING_SIZE];
+static volatile uint32_t samples_head = 0;          /* written by producer only */
+static volatile uint32_t samples_window_end = 0;    /* snapshot of samples_head at the last window (slice) boundary */
+static uint32_t samples_next_window = 0;            /* producer: position of the next boundary */
+static uint32_t samples_consumed = 0;               /* consumer: end of the last classified data */
+static uint32_t samples_read_start = 0;             /* consumer: first position visible through the signal */
+static uint32_t samples_first_window = 0;           /* position of the first boundary */
+/* consumer statistics */
+static uint32_t stat_inferences = 0;
+static uint32_t stat_skipped = 0;      /* boundaries passed while the previous inference was running */
+static uint32_t stat_overruns = 0;     /* classified data overwritten by the producer */
 const char truncate[] = ".."; /* used to truncate long labels */
 
 /**
@@ -74,23 +112,90 @@ bool samples_callback(const void *raw_sample, uint32_t raw_sample_size)
         return true;
     }
 
-    float *sample = (float *)raw_sample;
+    const float *sample = (const float *)raw_sample;
+    uint32_t head = samples_head;
+#if SAMPLES_RING_COUNTS == 1
+    /* the samples are counts * units_per_count, so rounding gets the exact counts back */
+    const float counts_per_unit = 1.0f / ei_inertial_sensor_units_per_count();
+#endif
 
     for(int i = 0; i < (int)(raw_sample_size / sizeof(float)); i++) {
-        samples_circ_buff[samples_wr_index++] = sample[i];
-        if (samples_wr_index > EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE) {
-            /* start from beginning of the circular buffer */
-            samples_wr_index = 0;
-        }
-        if (samples_wr_index >= samples_per_inference) {
-            state = INFERENCE_DATA_READY;
-            return true;
-        }
+#if SAMPLES_RING_COUNTS == 1
+        samples_ring[head % SAMPLES_RING_SIZE] = (int16_t)lrintf(sample[i] * counts_per_unit);
+#else
+        samples_ring[head % SAMPLES_RING_SIZE] = sample[i];
+#endif
+        head++;
+    }
+    /* publish the frame only once it's complete */
+    samples_head = head;
+
+    if (head >= samples_next_window) {
+        samples_window_end = samples_next_window;
+        samples_next_window += samples_per_inference;
     }
 
     return false;
 }
 
+/**
+ * @brief signal_t::get_data reading straight from the ring, across the wrap point
+ */
+static int samples_ring_get_data(size_t offset, size_t length, float *out_ptr)
+{
+    size_t ix = (samples_read_start + offset) % SAMPLES_RING_SIZE;
+#if SAMPLES_RING_COUNTS == 1
+    const float units_per_count = ei_inertial_sensor_units_per_count();
+
+    for (size_t i = 0; i < length; i++) {
+        out_ptr[i] = samples_ring[ix] * units_per_count;
+        if (++ix == SAMPLES_RING_SIZE) {
+            ix = 0;
+        }
+    }
+#else
+    size_t first = SAMPLES_RING_SIZE - ix;
+
+    if (first > length) {
+        first = length;
+    }
+    memcpy(out_ptr, &samples_ring[ix], first * sizeof(float));
+    memcpy(out_ptr + first, &samples_ring[0], (length - first) * sizeof(float));
+#endif
+
+    return 0;
+}
+
+#if SAMPLES_RING_COUNTS == 1
+/**
+ * @brief signal_i16_t::get_data, raw counts from the ring
+ */
+static int samples_ring_get_data_i16(size_t offset, size_t length, int16_t *out_ptr)
+{
+    size_t ix = (samples_read_start + offset) % SAMPLES_RING_SIZE;
+    size_t first = SAMPLES_RING_SIZE - ix;
+
+    if (first > length) {
+        first = length;
+    }
+    memcpy(out_ptr, &samples_ring[ix], first * sizeof(int16_t));
+    memcpy(out_ptr + first, &samples_ring[0], (length - first) * sizeof(int16_t));
+
+    return 0;
+}
+#endif
+
+/**
+ * @brief Reset the ring before sampling starts
+ */
+static void samples_ring_reset(void)
+{
+    samples_head = 0;
+    samples_window_end = 0;
+    samples_next_window = samples_first_window;
+    samples_consumed = 0;
+}
+
 static void process_results(ei_impulse_result_t* result)
 {
     static int ble_inference_settings_ready = 0;
@@ -151,37 +256,58 @@ void ei_run_impulse(void)
             // nothing to do
             return;
         case INFERENCE_WAITING:
-            if (ei_read_timer_ms() < (last_inference_ts + 2000)) {
+            if (ei_sched_enabled() == true) {
+                if (ei_sched_time_to_window_ms() > 0) {
+                    // sleep until the window is due, a received char wakes us up early
+                    ei_sched_idle();
+                    return;
+                }
+                ei_sched_window_started();
+            }
+            else if (ei_read_timer_ms() < (last_inference_ts + 2000)) {
                 return;
             }
+            samples_ring_reset();
             state = INFERENCE_SAMPLING;
             ei_fusion_sample_start(&samples_callback, EI_CLASSIFIER_INTERVAL_MS);
             dev->set_state(eiStateSampling);
             return;
         case INFERENCE_SAMPLING:
-            // wait for data to be collected through callback
-            return;
-        case INFERENCE_DATA_READY:
-            dev->set_state(eiStateIdle);
-            // nothing to do, just continue to inference provcessing below
+            if (samples_window_end == samples_consumed) {
+                // wait for data to be collected through callback
+                return;
+            }
             break;
         default:
             break;
     }
 
+    // snapshot, the producer keeps sampling while we classify
+    uint32_t window_end = samples_window_end;
+    uint32_t expected_end = (samples_consumed == 0) ? samples_first_window : samples_consumed + samples_per_inference;
+    uint64_t active_start_us = ei_read_timer_us();
     signal_t signal;
 
-    // shift circular buffer, so the newest data will be the first
-    // if samples_wr_index is 0, then roll is immediately returning
-    numpy::roll(samples_circ_buff, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, (-samples_wr_index));
-    /* reset wr index, the oldest data will be overwritten */
-    samples_wr_index = 0;
+    stat_inferences++;
+    stat_skipped += (window_end - expected_end) / samples_per_inference;
 
-    // Create a data structure to represent this window of data
-    int err = numpy::signal_from_buffer(samples_circ_buff, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &signal);
-    if (err != 0) {
-        ei_printf("ERR: signal_from_buffer failed (%d)\n", err);
+    if (continuous_mode == true) {
+        // the classifier keeps the window and takes exactly one slice per call,
+        // slices missed while the previous inference ran are dropped (counted in stat_skipped)
+        samples_read_start = window_end - samples_per_inference;
+        signal.total_length = samples_per_inference;
+    }
+    else {
+        if (gapless_mode == false) {
+            // sampling stops at the window boundary, see samples_callback()
+            state = INFERENCE_WAITING;
+            dev->set_state(eiStateIdle);
+        }
+        samples_read_start = window_end - EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+        signal.total_length = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
     }
+    signal.get_data = &samples_ring_get_data;
+    samples_consumed = window_end;
 
     // run the impulse: DSP, neural network and the Anomaly algorithm
     ei_impulse_result_t result = { 0 };
@@ -190,7 +316,20 @@ void ei_run_impulse(void)
         ei_error = run_classifier_continuous(&signal, &result, debug_mode);
     }
     else {
+#if SAMPLES_RING_COUNTS == 1
+        signal_i16_t signal_i16;
+        signal_i16.total_length = signal.total_length;
+        signal_i16.get_data = &samples_ring_get_data_i16;
+        signal_i16.scale = ei_inertial_sensor_units_per_count();
+        ei_error = run_classifier_i16(&signal_i16, &result, debug_mode);
+#else
         ei_error = run_classifier(&signal, &result, debug_mode);
+#endif
+    }
+
+    if (samples_head - samples_read_start > SAMPLES_RING_SIZE) {
+        ei_printf("WARN: inference too slow, samples overwritten while classifying\n");
+        stat_overruns++;
     }
 
     if (ei_error != EI_IMPULSE_OK) {
@@ -210,13 +349,17 @@ void ei_run_impulse(void)
         process_results(&result);
     }
 
-    if (continuous_mode == true) {
-        state = INFERENCE_SAMPLING;
+    if (debug_mode == true) {
+        ei_printf("Inferences: %lu, skipped: %lu, overruns: %lu\n", stat_inferences, stat_skipped, stat_overruns);
     }
-    else {
+
+    if (ei_sched_enabled() == true) {
+        ei_sched_add_active_us(ei_read_timer_us() - active_start_us);
+        ei_sched_print_stats();
+    }
+    else if (continuous_mode == false && gapless_mode == false) {
         ei_printf("Starting inferencing in 2 seconds...\n");
         last_inference_ts = ei_read_timer_ms();
-        state = INFERENCE_WAITING;
     }
 }
 
@@ -232,6 +375,10 @@ void ei_start_impulse(bool continuous, bool debug, bool use_max_uart_speed)
 
     continuous_mode = continuous;
     debug_mode = debug;
+    gapless_mode = (EI_FUSION_GAPLESS_SAMPLING == 1) && (ei_sched_enabled() == false);
+    stat_inferences = 0;
+    stat_skipped = 0;
+    stat_overruns = 0;
 
     // summary of inferencing settings (from model_metadata.h)
     ei_printf("Inferencing settings:\n");
@@ -240,6 +387,9 @@ void ei_start_impulse(bool continuous, bool debug, bool use_max_uart_speed)
     ei_printf("\tSample length: %.02f ms.\n", (float)(EI_CLASSIFIER_RAW_SAMPLE_COUNT * EI_CLASSIFIER_INTERVAL_MS));
     ei_printf("\tNo. of classes: %d\n", sizeof(ei_classifier_inferencing_categories) /
                                             sizeof(ei_classifier_inferencing_categories[0]));
+    if (continuous == false && gapless_mode == true) {
+        ei_printf("\tGapless, stride: %d samples\n", EI_FUSION_INFERENCE_STRIDE);
+    }
     ei_printf("Starting inferencing, press 'b' to break\n");
 
     dev->set_sample_length_ms(EI_CLASSIFIER_RAW_SAMPLE_COUNT * EI_CLASSIFIER_INTERVAL_MS, false);
@@ -247,16 +397,37 @@ void ei_start_impulse(bool continuous, bool debug, bool use_max_uart_speed)
 
     if (continuous == true) {
         samples_per_inference = EI_CLASSIFIER_SLICE_SIZE * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+        samples_first_window = samples_per_inference;
         // In order to have meaningful classification results, continuous inference has to run over
         // the complete model window. So the first iterations will print out garbage.
         // We now use a fixed length moving average filter of half the slices per model window and
         // only print when we run the complete maf buffer to prevent printing the same classification multiple times.
         print_results = -(EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW);
         run_classifier_init();
+        samples_ring_reset();
         state = INFERENCE_SAMPLING;
+        ei_fusion_sample_start(&samples_callback, EI_CLASSIFIER_INTERVAL_MS);
+        dev->set_state(eiStateSampling);
     }
-    else {
+    else if (ei_sched_enabled() == true) {
+        // the window may be longer than the model window to let the sensors settle,
+        // only the last model window is classified
+        uint32_t window_frames = (uint32_t)(ei_sched_window_ms() / EI_CLASSIFIER_INTERVAL_MS);
+        if (window_frames < EI_CLASSIFIER_RAW_SAMPLE_COUNT) {
+            window_frames = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+        }
         samples_per_inference = EI_CLASSIFIER_RAW_SAMPLE_COUNT * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+        samples_first_window = window_frames * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+        state = INFERENCE_WAITING;
+    }
+    else {
+        if (gapless_mode == true) {
+            samples_per_inference = EI_FUSION_INFERENCE_STRIDE * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+        }
+        else {
+            samples_per_inference = EI_CLASSIFIER_RAW_SAMPLE_COUNT * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+        }
+        samples_first_window = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
         // it's time to prepare for sampling
         ei_printf("Starting inferencing in 2 seconds...\n");
         last_inference_ts = ei_read_timer_ms();
@@ -264,6 +435,28 @@ void ei_start_impulse(bool continuous, bool debug, bool use_max_uart_speed)
     }
 }
 
+void ei_start_impulse_scheduled(uint32_t period_ms, uint32_t window_ms, bool debug)
+{
+    const uint32_t model_window_ms = (uint32_t)(EI_CLASSIFIER_RAW_SAMPLE_COUNT * EI_CLASSIFIER_INTERVAL_MS);
+
+    if (window_ms < model_window_ms) {
+        ei_printf("WARN: window shorter than the model window, using %lu ms\n", model_window_ms);
+        window_ms = model_window_ms;
+    }
+    if (period_ms < window_ms) {
+        ei_printf("ERR: period has to be at least %lu ms\n", window_ms);
+        return;
+    }
+
+    ei_sched_start(period_ms, window_ms);
+    ei_start_impulse(false, debug);
+    if (state == INFERENCE_STOPPED) {
+        ei_sched_stop();
+        return;
+    }
+    ei_printf("Scheduled: %lu ms window every %lu ms\n", window_ms, period_ms);
+}
+
 void ei_stop_impulse(void)
 {
     EiDeviceInfo *dev = EiDeviceInfo::get_device();
@@ -272,9 +465,8 @@ void ei_stop_impulse(void)
         state = INFERENCE_STOPPED;
         ei_printf("Inferencing stopped by user\r\n");
         dev->set_state(eiStateFinished);
-        /* reset samples buffer */
-        samples_wr_index = 0;
     }
+    ei_sched_stop();
 }
 
 bool is_inference_running(void)
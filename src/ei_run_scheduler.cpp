@@ -0,0 +1,200 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ei_run_scheduler.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "cyhal.h"
+#include "cy_retarget_io.h"
+
+#ifdef FREERTOS_ENABLED
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+/* don't bother going to sleep for less than that */
+#define SCHED_MIN_SLEEP_MS      2
+#define SCHED_UART_WAKE_PRIORITY 7
+
+typedef struct {
+    bool enabled;
+    uint32_t period_ms;
+    uint32_t window_ms;
+    uint64_t next_window_ms;
+    uint64_t start_ms;
+    uint64_t active_us;     /* DSP, inference and reporting */
+    uint64_t sleep_ms;      /* time spent in ei_sched_idle() */
+    uint32_t windows;
+} ei_sched_t;
+
+static ei_sched_t sched;
+#ifdef FREERTOS_ENABLED
+static TaskHandle_t sleeping_task = nullptr;
+#endif
+static volatile bool uart_wake = false;
+
+/**
+ * @brief Any character on the debug UART ends the sleep (AT commands, 'b' to stop).
+ * The event is disabled here, the FIFO is read later by the AT server.
+ */
+static void sched_uart_wake_cb(void *callback_arg, cyhal_uart_event_t event)
+{
+    cyhal_uart_enable_event(&cy_retarget_io_uart_obj, CYHAL_UART_IRQ_RX_NOT_EMPTY, SCHED_UART_WAKE_PRIORITY, false);
+    uart_wake = true;
+#ifdef FREERTOS_ENABLED
+    if(sleeping_task != nullptr) {
+        BaseType_t higher_priority_task_woken = pdFALSE;
+        vTaskNotifyGiveFromISR(sleeping_task, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
+#endif
+}
+
+void ei_sched_start(uint32_t period_ms, uint32_t window_ms)
+{
+    sched.enabled = true;
+    sched.period_ms = period_ms;
+    sched.window_ms = window_ms;
+    sched.next_window_ms = ei_read_timer_ms();
+    sched.start_ms = ei_read_timer_ms();
+    sched.active_us = 0;
+    sched.sleep_ms = 0;
+    sched.windows = 0;
+
+    cyhal_uart_register_callback(&cy_retarget_io_uart_obj, sched_uart_wake_cb, nullptr);
+}
+
+void ei_sched_stop(void)
+{
+    if(sched.enabled) {
+        cyhal_uart_enable_event(&cy_retarget_io_uart_obj, CYHAL_UART_IRQ_RX_NOT_EMPTY, SCHED_UART_WAKE_PRIORITY, false);
+        cyhal_uart_register_callback(&cy_retarget_io_uart_obj, nullptr, nullptr);
+    }
+    sched.enabled = false;
+}
+
+bool ei_sched_enabled(void)
+{
+    return sched.enabled;
+}
+
+uint32_t ei_sched_window_ms(void)
+{
+    return sched.window_ms;
+}
+
+/**
+ * @brief Time left until the next acquisition window should start, 0 if it's due
+ */
+uint32_t ei_sched_time_to_window_ms(void)
+{
+    uint64_t now = ei_read_timer_ms();
+
+    if(!sched.enabled || now >= sched.next_window_ms) {
+        return 0;
+    }
+
+    return (uint32_t)(sched.next_window_ms - now);
+}
+
+/**
+ * @brief Acquisition window is starting, schedule the next one.
+ * Periods that were missed (inference longer than the period) are skipped.
+ */
+void ei_sched_window_started(void)
+{
+    uint64_t now = ei_read_timer_ms();
+
+    sched.windows++;
+    sched.next_window_ms += sched.period_ms;
+    if(sched.next_window_ms <= now) {
+        sched.next_window_ms = now + sched.period_ms;
+    }
+}
+
+void ei_sched_add_active_us(uint64_t active_us)
+{
+    sched.active_us += active_us;
+}
+
+/**
+ * @brief Sleep until the next window is due or a character arrives on the UART.
+ * Blocking the task lets the tickless idle put the CPU to (deep) sleep,
+ * the wake up comes from the low power timer or the UART interrupt.
+ * The sleep is measured with the ms tick, the DWT based us timer stops in deep sleep.
+ */
+void ei_sched_idle(void)
+{
+    uint32_t sleep_ms = ei_sched_time_to_window_ms();
+
+    if(sleep_ms < SCHED_MIN_SLEEP_MS || cyhal_uart_readable(&cy_retarget_io_uart_obj) > 0) {
+        return;
+    }
+
+    uint64_t sleep_start = ei_read_timer_ms();
+
+    uart_wake = false;
+#ifdef FREERTOS_ENABLED
+    /* the task has to be known before the event is enabled, a character arriving in
+     * between would set uart_wake without a notification */
+    sleeping_task = xTaskGetCurrentTaskHandle();
+    cyhal_uart_enable_event(&cy_retarget_io_uart_obj, CYHAL_UART_IRQ_RX_NOT_EMPTY, SCHED_UART_WAKE_PRIORITY, true);
+    if(!uart_wake) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleep_ms));
+    }
+    sleeping_task = nullptr;
+    /* drop a notification given after the timeout, so the next sleep isn't cut short */
+    ulTaskNotifyTake(pdTRUE, 0);
+#else
+    cyhal_uart_enable_event(&cy_retarget_io_uart_obj, CYHAL_UART_IRQ_RX_NOT_EMPTY, SCHED_UART_WAKE_PRIORITY, true);
+    while(!uart_wake && ei_sched_time_to_window_ms() > 0) {
+        cyhal_syspm_sleep();
+    }
+#endif
+    cyhal_uart_enable_event(&cy_retarget_io_uart_obj, CYHAL_UART_IRQ_RX_NOT_EMPTY, SCHED_UART_WAKE_PRIORITY, false);
+
+    sched.sleep_ms += ei_read_timer_ms() - sleep_start;
+}
+
+void ei_sched_print_stats(void)
+{
+    uint64_t elapsed_ms = ei_read_timer_ms() - sched.start_ms;
+    uint32_t windows = sched.windows > 0 ? sched.windows : 1;
+
+    ei_printf("Schedule: period %lu ms, window %lu ms, windows %lu\n",
+        sched.period_ms, sched.window_ms, sched.windows);
+    ei_printf("\tactive: %lu us/inference, sleep: ",
+        (uint32_t)(sched.active_us / windows));
+    ei_printf_float(elapsed_ms > 0 ? 100.0f * (float)sched.sleep_ms / (float)elapsed_ms : 0.0f);
+    ei_printf("%% of %lu ms\n", (uint32_t)elapsed_ms);
+}
@@ -34,6 +34,7 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "firmware-sdk/ei_device_info_lib.h"
@@ -55,6 +56,24 @@ static uint8_t write_word_buf[4];
 static int write_addr = 0;
 EI_SENSOR_AQ_STREAM stream;
 
+/* Float encoding of the recorded samples. AQ_FLOAT_HALF saves 37% of the flash on IMU data,
+ * but rounds to ~13 sensor LSBs near 1 g (see tools/sensor-aq-benchmark) */
+#ifndef EI_SAMPLER_FLOAT_ENCODING
+#define EI_SAMPLER_FLOAT_ENCODING   AQ_FLOAT_LOSSLESS
+#endif
+
+/* Frames are queued here by the sample callback and encoded in batches by the sampler task */
+#ifndef EI_SAMPLER_RING_SIZE
+#define EI_SAMPLER_RING_SIZE        1024 /* in values, shared by all axes */
+#endif
+
+static float sample_ring[EI_SAMPLER_RING_SIZE];
+static uint32_t ring_frames;
+static uint32_t ring_axes;
+static volatile uint32_t ring_head; /* written by the sample callback only */
+static volatile uint32_t ring_tail; /* written by the sampler task only */
+static volatile uint32_t ring_dropped;
+
 static unsigned char ei_sensor_ctx_buffer[1024];
 static sensor_aq_mbedtls_hs256_ctx_t ei_sensor_hs_ctx;
 static sensor_aq_signing_ctx_t ei_sensor_signing_ctx;
@@ -200,7 +219,18 @@ static bool create_header(sensor_aq_payload_info *payload)
  */
 static bool sample_data_callback(const void *sample_buf, uint32_t byteLenght)
 {
-    sensor_aq_add_data(&ei_sensor_ctx, (float *)sample_buf, byteLenght / sizeof(float));
+    uint32_t head = ring_head;
+
+    if(sample_buf == nullptr || (byteLenght / sizeof(float)) != ring_axes) {
+        /* nothing sampled this tick */
+    }
+    else if((head - ring_tail) >= ring_frames) {
+        ring_dropped++;
+    }
+    else {
+        memcpy(&sample_ring[(head % ring_frames) * ring_axes], sample_buf, ring_axes * sizeof(float));
+        ring_head = head + 1;
+    }
 
     if(++current_sample > samples_required) {
         return true;
@@ -210,6 +240,32 @@ static bool sample_data_callback(const void *sample_buf, uint32_t byteLenght)
     }
 }
 
+/**
+ * @brief      Encode and write all frames queued by sample_data_callback.
+ *             Runs in the sampler task, so CBOR encoding, signing and FLASH
+ *             writes stay out of the sample timer callback.
+ */
+static void sample_ring_drain(void)
+{
+    uint32_t head = ring_head;
+
+    while(ring_tail != head) {
+        uint32_t start = ring_tail % ring_frames;
+        /* contiguous block up to the end of the ring */
+        uint32_t count = head - ring_tail;
+        if(count > ring_frames - start) {
+            count = ring_frames - start;
+        }
+
+        int ret = sensor_aq_add_frames(&ei_sensor_ctx, &sample_ring[start * ring_axes], count, ring_axes, EI_SAMPLER_FLOAT_ENCODING);
+        if(ret != AQ_OK) {
+            ei_printf("ERR: failed to encode samples (%d)\n", ret);
+        }
+
+        ring_tail += count;
+    }
+}
+
 /**
  * @brief      Sampling is finished, signal no uploading file
  *
@@ -241,28 +297,41 @@ bool ei_sampler_start_sampling(void *v_ptr_payload, starter_callback ei_sample_s
     samples_required = (uint32_t)((dev->get_sample_length_ms()) / dev->get_sample_interval_ms());
     sample_buffer_size = (samples_required * sample_size) * 2;
     current_sample = 0;
+    ring_head = 0;
+    ring_tail = 0;
+    ring_dropped = 0;
 
     ei_printf("Samples req: %d\n", samples_required);
 
-    // Minimum delay of 2000 ms for daemon
-    uint32_t delay_time_ms = ((sample_buffer_size / mem->block_size) + 1) * mem->block_erase_time;
-    ei_printf("Starting in %lu ms... (or until all flash was erased)\n", delay_time_ms < 2000 ? 2000 : delay_time_ms);
-
     dev->set_state(eiStateErasingFlash);
 
-    if(mem->erase_sample_data(0, sample_buffer_size) != (sample_buffer_size)) {
+    // only the beginning of the region is erased here, the rest is erased while sampling
+    uint64_t erase_start_ms = ei_read_timer_ms();
+    if(mem->erase_sample_data_ahead(0, sample_buffer_size) != (sample_buffer_size)) {
         return false;
     }
 
+    // Minimum delay of 2000 ms for daemon
+    uint32_t erase_time_ms = (uint32_t)(ei_read_timer_ms() - erase_start_ms);
+    uint32_t delay_time_ms = erase_time_ms < 2000 ? 2000 - erase_time_ms : 0;
+    ei_printf("Starting in %lu ms... (or until all flash was erased)\n", delay_time_ms);
+
     // if erasing took less than 2 seconds, wait additional time
-    if(delay_time_ms < 2000) {
-        ei_sleep(2000 - delay_time_ms);
+    if(delay_time_ms > 0) {
+        ei_sleep(delay_time_ms);
     }
 
     if (create_header(payload) == false) {
         return false;
     }
 
+    ring_axes = ei_sensor_ctx.axis_count;
+    ring_frames = ring_axes ? EI_SAMPLER_RING_SIZE / ring_axes : 0;
+    if (ring_frames == 0) {
+        ei_printf("ERR: %lu axes do not fit in the sample ring buffer\n", ring_axes);
+        return false;
+    }
+
     if (ei_sample_start(&sample_data_callback, dev->get_sample_interval_ms()) == false) {
         return false;
     }
@@ -270,12 +339,23 @@ bool ei_sampler_start_sampling(void *v_ptr_payload, starter_callback ei_sample_s
     ei_printf("Sampling...\n");
     dev->set_state(eiStateSampling);
 
-    while (current_sample < samples_required) {
+    // wait for the last callback, it leaves current_sample at samples_required + 1
+    while (current_sample <= samples_required) {
+        sample_ring_drain();
         ei_sleep(10);
     }
 
+    // write the frames still queued or held in the CBOR buffer
+    sample_ring_drain();
+    sensor_aq_flush(&ei_sensor_ctx);
+
+    if (ring_dropped > 0) {
+        ei_printf("WARN: %lu samples dropped, sample buffer was full\n", ring_dropped);
+    }
+
     ei_write_last_data();
     write_addr++;
+    mem->finalize_samplig();
 
     uint8_t final_byte[] = {0xff};
     int ctx_err = ei_sensor_ctx.signature_ctx->update(ei_sensor_ctx.signature_ctx, final_byte, 1);
@@ -0,0 +1,247 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Scoring time of the k-means anomaly block. Runs the SDK's
+ * get_min_distance_to_cluster() (squared distance bound, early termination)
+ * and a copy of the previous implementation, which took a double pow() and a
+ * sqrt() for every cluster, on the same random clusters and inputs. The old
+ * code runs twice: with pow() called from libm, and with pow() left to the
+ * compiler, which turns pow(x, 2) into a multiply.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "edge-impulse-sdk/classifier/inferencing_engines/anomaly.h"
+
+typedef struct {
+    uint32_t inputs;
+    uint32_t runs;
+    uint32_t seed;
+} options_t;
+
+static const size_t axes_list[] = { 3, 33, 64 };
+static const size_t clusters_list[] = { 8, 16, 32, 64, 128, 256 };
+
+/* the compiler can't see through the pointer, so this is a real libm call */
+static double (*volatile libm_pow)(double, double) = pow;
+
+/* Previous implementation ---------------------------------------------------*/
+
+static float reference_distance(const float *input, size_t input_size, const ei_classifier_anom_cluster_t *cluster, bool use_libm)
+{
+    float dist = 0.0f;
+    for (size_t ix = 0; ix < input_size; ix++) {
+        if (use_libm) {
+            dist += libm_pow(input[ix] - cluster->centroid[ix], 2);
+        }
+        else {
+            dist += pow(input[ix] - cluster->centroid[ix], 2);
+        }
+    }
+    return sqrt(dist) - cluster->max_error;
+}
+
+static float reference_min_distance(const float *input, size_t input_size, const ei_classifier_anom_cluster_t *clusters, size_t cluster_size, bool use_libm)
+{
+    float min = 1000.0f;
+    for (size_t ix = 0; ix < cluster_size; ix++) {
+        float dist = reference_distance(input, input_size, &clusters[ix], use_libm);
+        if (dist < min) {
+            min = dist;
+        }
+    }
+    return min;
+}
+
+/* Test data ----------------------------------------------------------------*/
+
+static uint32_t random_state;
+
+static float random_uniform(float min, float max)
+{
+    random_state = random_state * 1664525u + 1013904223u;
+    return min + (max - min) * (float)(random_state >> 8) / (float)(1u << 24);
+}
+
+/**
+ * Centroids spread over +-3 (standard scaled features), max_error 0.5 to 1.5.
+ * Inputs are a random centroid plus noise, so most of them score near a cluster
+ * and some are anomalies.
+ */
+static void make_model(const options_t *options, size_t axes, size_t clusters,
+    std::vector<float> &centroids, std::vector<ei_classifier_anom_cluster_t> &model, std::vector<float> &inputs)
+{
+    random_state = options->seed;
+
+    centroids.resize(clusters * axes);
+    model.resize(clusters);
+    for (size_t ix = 0; ix < centroids.size(); ix++) {
+        centroids[ix] = random_uniform(-3.0f, 3.0f);
+    }
+    for (size_t ix = 0; ix < clusters; ix++) {
+        model[ix].centroid = &centroids[ix * axes];
+        model[ix].max_error = random_uniform(0.5f, 1.5f);
+    }
+
+    inputs.resize(options->inputs * axes);
+    for (size_t ix = 0; ix < options->inputs; ix++) {
+        const float *centroid = model[(size_t)random_uniform(0.0f, (float)clusters) % clusters].centroid;
+        const float noise = (ix % 10 == 0) ? 2.0f : 0.5f;
+        for (size_t axis = 0; axis < axes; axis++) {
+            inputs[ix * axes + axis] = centroid[axis] + random_uniform(-noise, noise);
+        }
+    }
+}
+
+/* Benchmark ----------------------------------------------------------------*/
+
+typedef enum {
+    PATH_PRUNED,
+    PATH_LIBM_POW,
+    PATH_INLINED_POW
+} path_t;
+
+/**
+ * @return best ns per score over the runs, scores are written to `scores`
+ */
+static double run_path(const options_t *options, path_t path, size_t axes,
+    const std::vector<ei_classifier_anom_cluster_t> &model, std::vector<float> &inputs, std::vector<float> &scores)
+{
+    double best_ns = 0.0;
+
+    scores.resize(options->inputs);
+    for (uint32_t run = 0; run < options->runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t ix = 0; ix < options->inputs; ix++) {
+            float *input = &inputs[ix * axes];
+            switch (path) {
+                case PATH_PRUNED:
+                    scores[ix] = get_min_distance_to_cluster(input, axes, model.data(), model.size());
+                    break;
+                case PATH_LIBM_POW:
+                    scores[ix] = reference_min_distance(input, axes, model.data(), model.size(), true);
+                    break;
+                case PATH_INLINED_POW:
+                    scores[ix] = reference_min_distance(input, axes, model.data(), model.size(), false);
+                    break;
+            }
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || ns < best_ns) {
+            best_ns = ns;
+        }
+    }
+
+    return best_ns / options->inputs;
+}
+
+static void run(const options_t *options, size_t axes, size_t clusters, bool last)
+{
+    std::vector<float> centroids, inputs, pruned, libm, inlined;
+    std::vector<ei_classifier_anom_cluster_t> model;
+
+    make_model(options, axes, clusters, centroids, model, inputs);
+
+    double pruned_ns = run_path(options, PATH_PRUNED, axes, model, inputs, pruned);
+    double libm_ns = run_path(options, PATH_LIBM_POW, axes, model, inputs, libm);
+    double inlined_ns = run_path(options, PATH_INLINED_POW, axes, model, inputs, inlined);
+
+    float max_diff = 0.0f;
+    for (size_t ix = 0; ix < options->inputs; ix++) {
+        max_diff = fmaxf(max_diff, fabsf(pruned[ix] - libm[ix]));
+    }
+
+    printf("    { \"axes\": %zu, \"clusters\": %zu, \"pruned_ns\": %.1f, \"libm_pow_ns\": %.1f, \"inlined_pow_ns\": %.1f, "
+        "\"speedup_libm\": %.2f, \"speedup_inlined\": %.2f, \"max_score_diff\": %.2e }%s\n",
+        axes, clusters, pruned_ns, libm_ns, inlined_ns, libm_ns / pruned_ns, inlined_ns / pruned_ns,
+        (double)max_diff, last ? "" : ",");
+}
+
+static void print_usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --inputs N    inputs scored per run (default 2000)\n"
+        "  --runs N      runs per path, the fastest is reported (default 5)\n"
+        "  --seed N      seed of the random clusters and inputs (default 1)\n",
+        name);
+}
+
+int main(int argc, char **argv)
+{
+    options_t options = { 2000, 5, 1 };
+
+    for (int ix = 1; ix < argc; ix++) {
+        const char *arg = argv[ix];
+        const bool has_value = ix + 1 < argc;
+
+        if (strcmp(arg, "--inputs") == 0 && has_value) {
+            options.inputs = strtoul(argv[++ix], NULL, 0);
+        }
+        else if (strcmp(arg, "--runs") == 0 && has_value) {
+            options.runs = strtoul(argv[++ix], NULL, 0);
+        }
+        else if (strcmp(arg, "--seed") == 0 && has_value) {
+            options.seed = strtoul(argv[++ix], NULL, 0);
+        }
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.inputs == 0 || options.runs == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const size_t axes_count = sizeof(axes_list) / sizeof(axes_list[0]);
+    const size_t clusters_count = sizeof(clusters_list) / sizeof(clusters_list[0]);
+
+    printf("{\n  \"inputs\": %u,\n  \"results\": [\n", options.inputs);
+    for (size_t a = 0; a < axes_count; a++) {
+        for (size_t c = 0; c < clusters_count; c++) {
+            run(&options, axes_list[a], clusters_list[c], a + 1 == axes_count && c + 1 == clusters_count);
+        }
+    }
+    printf("  ]\n}\n");
+
+    return 0;
+}
@@ -0,0 +1,501 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Per-sample cost and heap use of the sensor fusion sampling path. Runs the
+ * real ei_fusion_read_axis_data() (static gather plan) and a copy of the
+ * previous implementation, which allocated the fused frame on every tick, on
+ * the same fake sensors. ei_malloc() goes to a small first-fit heap with
+ * coalescing like FreeRTOS heap_4, so the fragmentation either path leaves
+ * behind can be measured. A "background" allocation made from the sampler
+ * callback stands in for another task allocating while the tick runs.
+ */
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "firmware-sdk/ei_fusion.h"
+#include "firmware-sdk/ei_device_info_lib.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+typedef struct {
+    uint32_t samples;
+    uint32_t heap_size;
+    uint32_t background_every;
+    uint32_t runs;
+} options_t;
+
+/* Heap model, first fit with coalescing of neighbours (as heap_4) ----------*/
+
+#define HEAP_ALIGN      8
+#define HEAP_HEADER     8   /* block size + used flag, like heap_4's BlockLink_t */
+
+typedef struct {
+    uint32_t size;      /* including the header */
+    uint32_t used;
+} heap_block_t;
+
+static std::vector<uint8_t> heap;
+static uint32_t heap_calls;
+static uint32_t heap_used;
+static uint32_t heap_peak;
+static uint32_t heap_failed;
+
+static heap_block_t *heap_block(uint32_t offset)
+{
+    return (heap_block_t *)&heap[offset];
+}
+
+static void heap_reset(uint32_t size)
+{
+    heap.assign(size, 0);
+    heap_block(0)->size = size;
+    heap_block(0)->used = 0;
+    heap_calls = 0;
+    heap_used = 0;
+    heap_peak = 0;
+    heap_failed = 0;
+}
+
+static void *heap_alloc(size_t size)
+{
+    uint32_t needed = (uint32_t)((size + HEAP_HEADER + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1));
+
+    heap_calls++;
+    for(uint32_t offset = 0; offset < heap.size(); offset += heap_block(offset)->size) {
+        heap_block_t *block = heap_block(offset);
+        if(block->used || block->size < needed) {
+            continue;
+        }
+        /* split if the rest can hold another block */
+        if(block->size - needed >= HEAP_HEADER + HEAP_ALIGN) {
+            heap_block(offset + needed)->size = block->size - needed;
+            heap_block(offset + needed)->used = 0;
+            block->size = needed;
+        }
+        block->used = 1;
+        heap_used += block->size;
+        if(heap_used > heap_peak) {
+            heap_peak = heap_used;
+        }
+        return &heap[offset + HEAP_HEADER];
+    }
+
+    heap_failed++;
+    return NULL;
+}
+
+static void heap_release(void *ptr)
+{
+    if(ptr == NULL) {
+        return;
+    }
+
+    heap_calls++;
+    uint32_t target = (uint32_t)((uint8_t *)ptr - &heap[0]) - HEAP_HEADER;
+    heap_block(target)->used = 0;
+    heap_used -= heap_block(target)->size;
+
+    /* merge runs of free blocks */
+    uint32_t offset = 0;
+    while(offset < heap.size()) {
+        heap_block_t *block = heap_block(offset);
+        while(!block->used && offset + block->size < heap.size() && !heap_block(offset + block->size)->used) {
+            block->size += heap_block(offset + block->size)->size;
+        }
+        offset += block->size;
+    }
+}
+
+/**
+ * 1 - largest free block / free bytes, 0 if all free memory is one block
+ */
+static float heap_fragmentation(uint32_t *free_blocks)
+{
+    uint32_t total = 0;
+    uint32_t largest = 0;
+
+    *free_blocks = 0;
+    for(uint32_t offset = 0; offset < heap.size(); offset += heap_block(offset)->size) {
+        heap_block_t *block = heap_block(offset);
+        if(!block->used) {
+            total += block->size;
+            largest = block->size > largest ? block->size : largest;
+            (*free_blocks)++;
+        }
+    }
+
+    return total > 0 ? 1.0f - (float)largest / (float)total : 0.0f;
+}
+
+void *ei_malloc(size_t size)
+{
+    return heap_alloc(size);
+}
+
+void *ei_calloc(size_t nitems, size_t size)
+{
+    void *ptr = heap_alloc(nitems * size);
+    if(ptr != NULL) {
+        memset(ptr, 0, nitems * size);
+    }
+    return ptr;
+}
+
+void ei_free(void *ptr)
+{
+    heap_release(ptr);
+}
+
+void ei_printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+void ei_printf_float(float f)
+{
+    ei_printf("%f", f);
+}
+
+uint64_t ei_read_timer_us(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* ei_fusion_setup_data_sampling() hands over to the sampler, not used here */
+bool ei_sampler_start_sampling(void *v_ptr_payload, starter_callback ei_sample_start, uint32_t sample_size)
+{
+    return false;
+}
+
+/* Device and sensors -------------------------------------------------------*/
+
+class EiDeviceBenchmark : public EiDeviceInfo {
+public:
+    void init_device_id(void) override
+    {
+    }
+
+    bool start_sample_thread(void (*sample_read_cb)(void), float sample_interval_ms) override
+    {
+        return true;
+    }
+
+    bool stop_sample_thread(void) override
+    {
+        return true;
+    }
+
+    /* like EiDevicePSoC62, the tick time is just a stored value */
+    uint64_t get_sample_timestamp_us(void) override
+    {
+        return sample_time_us += 16000;
+    }
+
+private:
+    uint64_t sample_time_us = 0;
+};
+
+EiDeviceInfo *EiDeviceInfo::get_device(void)
+{
+    static EiDeviceBenchmark dev;
+    return &dev;
+}
+
+static float inertial_data[6];
+static float environment_data[4];
+
+static float *read_inertial(int n_samples)
+{
+    for(int ix = 0; ix < 6; ix++) {
+        inertial_data[ix] += 0.25f;
+    }
+    return inertial_data;
+}
+
+static float *read_environment(int n_samples)
+{
+    for(int ix = 0; ix < 4; ix++) {
+        environment_data[ix] += 0.5f;
+    }
+    return environment_data;
+}
+
+static const ei_device_fusion_sensor_t inertial_sensor = {
+    "Inertial", 6, { 62.5f, 100.0f },
+    { { "accX", "m/s2" }, { "accY", "m/s2" }, { "accZ", "m/s2" }, { "gyrX", "dps" }, { "gyrY", "dps" }, { "gyrZ", "dps" } },
+    &read_inertial, 0
+};
+
+static const ei_device_fusion_sensor_t environment_sensor = {
+    "Environmental", 4, { 1.0f, 10.0f },
+    { { "temperature", "Cel" }, { "humidity", "%RH" }, { "pressure", "Pa" }, { "gas", "Ohm" } },
+    &read_environment, 0
+};
+
+/* Sampling -----------------------------------------------------------------*/
+
+typedef struct {
+    const char *name;
+    const char *axes;
+} fusion_list_t;
+
+static const fusion_list_t fusion_lists[] = {
+    { "imu_3", "accX + accY + accZ" },
+    { "imu_env_6", "accX + accZ + gyrY + temperature + humidity + gas" },
+    { "all_10", "accX + accY + accZ + gyrX + gyrY + gyrZ + temperature + humidity + pressure + gas" },
+};
+
+extern std::vector<ei_device_fusion_sensor_t> fusable_sensor_list;
+extern int num_fusion_axis;
+
+static const options_t *bench_options;
+static bool collect_heap_stats;
+static float fragmentation_sum;
+static float fragmentation_max;
+static uint32_t fragmentation_samples;
+static uint32_t samples_left;
+static uint32_t sample_count;
+static float checksum;
+#define BACKGROUND_SLOTS    16
+static void *background[BACKGROUND_SLOTS];
+
+/**
+ * Sampler callback. Every `background_every` samples another allocation is made
+ * while the fused frame is in use, and freed BACKGROUND_SLOTS allocations later.
+ */
+static bool sampler_callback_fn(const void *sample_buf, uint32_t byte_length)
+{
+    const float *values = (const float *)sample_buf;
+
+    for(uint32_t ix = 0; ix < byte_length / sizeof(float); ix++) {
+        checksum += values[ix];
+    }
+
+    if(bench_options->background_every > 0 && sample_count % bench_options->background_every == 0) {
+        uint32_t slot = (sample_count / bench_options->background_every) % BACKGROUND_SLOTS;
+        ei_free(background[slot]);
+        background[slot] = ei_malloc(16 + (sample_count * 7919u) % 96);
+
+        if(collect_heap_stats) {
+            uint32_t free_blocks;
+            float fragmentation = heap_fragmentation(&free_blocks);
+            fragmentation_sum += fragmentation;
+            fragmentation_max = fragmentation > fragmentation_max ? fragmentation : fragmentation_max;
+            fragmentation_samples++;
+        }
+    }
+    sample_count++;
+
+    return --samples_left == 0;
+}
+
+/**
+ * ei_fusion_read_axis_data() before the gather plan: frame allocated per tick,
+ * the axis mask checked for every sensor axis
+ */
+static std::vector<ei_device_fusion_sensor_t *> legacy_sensors;
+
+static void legacy_read_axis_data(void)
+{
+    fusion_sample_format_t *sensor_data;
+    fusion_sample_format_t *data;
+    uint32_t loc = 0;
+
+    data = (fusion_sample_format_t *)ei_malloc(sizeof(fusion_sample_format_t) * num_fusion_axis);
+    if (data == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < legacy_sensors.size(); i++) {
+        sensor_data = legacy_sensors[i]->read_data(legacy_sensors[i]->num_axis);
+
+        if (sensor_data != NULL) {
+            for (int j = 0; j < legacy_sensors[i]->num_axis; j++) {
+                if (legacy_sensors[i]->axis_flag_used & (1 << j)) {
+                    data[loc++] = *(sensor_data + j);
+                }
+            }
+        }
+        else {
+            for (int j = 0; j < legacy_sensors[i]->num_axis; j++) {
+                if (legacy_sensors[i]->axis_flag_used & (1 << j)) {
+                    data[loc++] = 0;
+                }
+            }
+        }
+    }
+
+    sampler_callback_fn(&data[0], sizeof(fusion_sample_format_t) * num_fusion_axis);
+
+    ei_free(data);
+}
+
+static bool run(const options_t *options, const fusion_list_t *list, bool legacy, bool last)
+{
+    double best_ns = 0.0;
+    uint32_t calls = 0;
+    uint32_t peak = 0;
+    uint32_t failed = 0;
+
+    /* the first run walks the heap after every background allocation, it's only timed if it's the only one */
+    for(uint32_t run = 0; run < options->runs; run++) {
+        collect_heap_stats = run == 0;
+        heap_reset(options->heap_size);
+        memset(background, 0, sizeof(background));
+
+        for(ei_device_fusion_sensor_t &sensor : fusable_sensor_list) {
+            sensor.axis_flag_used = 0;
+        }
+        if(!ei_connect_fusion_list(list->axes, AXIS_FORMAT)) {
+            fprintf(stderr, "ERR: failed to connect %s\n", list->axes);
+            return false;
+        }
+        ei_fusion_sample_start(sampler_callback_fn, 16.0f);
+
+        legacy_sensors.clear();
+        for(ei_device_fusion_sensor_t &sensor : fusable_sensor_list) {
+            if(sensor.axis_flag_used != 0) {
+                legacy_sensors.push_back(&sensor);
+            }
+        }
+
+        /* setup allocations are not part of the sampling */
+        heap_calls = 0;
+        if(collect_heap_stats) {
+            fragmentation_sum = 0.0f;
+            fragmentation_max = 0.0f;
+            fragmentation_samples = 0;
+        }
+        samples_left = options->samples;
+        sample_count = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for(uint32_t ix = 0; ix < options->samples; ix++) {
+            if(legacy) {
+                legacy_read_axis_data();
+            }
+            else {
+                ei_fusion_read_axis_data();
+            }
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        if(run == 0) {
+            calls = heap_calls;
+            peak = heap_peak;
+            failed = heap_failed;
+        }
+        if((run > 0 || options->runs == 1) && (best_ns == 0.0 || ns < best_ns)) {
+            best_ns = ns;
+        }
+    }
+
+    printf("    { \"axes\": \"%s\", \"path\": \"%s\", \"ns_per_sample\": %.1f, \"heap_calls_per_sample\": %.2f, "
+        "\"heap_peak_bytes\": %lu, \"failed_allocations\": %lu, \"fragmentation_avg\": %.3f, \"fragmentation_max\": %.3f }%s\n",
+        list->name, legacy ? "malloc" : "gather_plan", best_ns / options->samples,
+        (double)calls / options->samples, (unsigned long)peak, (unsigned long)failed,
+        fragmentation_samples > 0 ? fragmentation_sum / fragmentation_samples : 0.0f, fragmentation_max, last ? "" : ",");
+
+    return true;
+}
+
+static void print_usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --samples N            fused samples per run (default 100000)\n"
+        "  --heap BYTES           size of the modelled heap (default 4096)\n"
+        "  --background-every N   background allocation every N samples, 0 = none (default 10)\n"
+        "  --runs N               runs per path, the fastest is reported (default 5)\n",
+        name);
+}
+
+int main(int argc, char **argv)
+{
+    options_t options = { 100000, 4096, 10, 5 };
+
+    for(int ix = 1; ix < argc; ix++) {
+        const char *arg = argv[ix];
+        const bool has_value = ix + 1 < argc;
+
+        if(strcmp(arg, "--samples") == 0 && has_value) {
+            options.samples = strtoul(argv[++ix], NULL, 0);
+        }
+        else if(strcmp(arg, "--heap") == 0 && has_value) {
+            options.heap_size = strtoul(argv[++ix], NULL, 0);
+        }
+        else if(strcmp(arg, "--background-every") == 0 && has_value) {
+            options.background_every = strtoul(argv[++ix], NULL, 0);
+        }
+        else if(strcmp(arg, "--runs") == 0 && has_value) {
+            options.runs = strtoul(argv[++ix], NULL, 0);
+        }
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(options.samples == 0 || options.runs == 0 || options.heap_size < 256) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    bench_options = &options;
+    ei_add_sensor_to_fusion_list(inertial_sensor);
+    ei_add_sensor_to_fusion_list(environment_sensor);
+
+    bool ok = true;
+    const size_t list_count = sizeof(fusion_lists) / sizeof(fusion_lists[0]);
+
+    printf("{\n  \"samples\": %u,\n  \"heap_size\": %u,\n  \"background_every\": %u,\n  \"results\": [\n",
+        options.samples, options.heap_size, options.background_every);
+    for(size_t ix = 0; ix < list_count; ix++) {
+        ok &= run(&options, &fusion_lists[ix], true, false);
+        ok &= run(&options, &fusion_lists[ix], false, ix + 1 == list_count);
+    }
+    printf("  ]\n}\n");
+    fprintf(stderr, "checksum: %f\n", checksum);
+
+    return ok ? 0 : 1;
+}
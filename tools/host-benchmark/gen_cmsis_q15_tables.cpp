@@ -0,0 +1,127 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The CMSIS-DSP sources in the SDK come without arm_common_tables.c (the device build
+ * links the one of the cmsis library). For make Q15=1 this prints the tables the q15
+ * RFFT needs, as C, on stdout: twiddleCoef_<n>_q15, realCoefAQ15 / realCoefBQ15 and
+ * armBitRevIndexTable_fixed_<n>. Values are floor(x * 2^15), saturated, like the CMSIS
+ * tables. The radix-4 and radix-4 by 2 q15 butterflies write in bit reversed order, so
+ * the index tables swap every bin with its bit reversed one (byte offset * 2, as read by
+ * arm_bitreversal_16()).
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+static const double pi = 3.14159265358979323846;
+
+static int16_t to_q15(double value)
+{
+    // the epsilon keeps e.g. cos(pi / 2) = 6e-17 at 0
+    double v = std::floor(value * 32768.0 + 1e-9);
+    return (int16_t)(v > 32767.0 ? 32767.0 : (v < -32768.0 ? -32768.0 : v));
+}
+
+static void print_q15(const char *name, const std::vector<int16_t> &values)
+{
+    printf("const q15_t %s[%u] = {", name, (unsigned)values.size());
+    for (size_t ix = 0; ix < values.size(); ix++) {
+        printf("%s%d", ix % 16 == 0 ? "\n    " : " ", values[ix]);
+        printf(ix + 1 < values.size() ? "," : "\n");
+    }
+    printf("};\n\n");
+}
+
+static void print_u16(const char *name, const std::vector<uint16_t> &values)
+{
+    printf("const uint16_t %s[%u] = {", name, (unsigned)values.size());
+    for (size_t ix = 0; ix < values.size(); ix++) {
+        printf("%s%u", ix % 16 == 0 ? "\n    " : " ", values[ix]);
+        printf(ix + 1 < values.size() ? "," : "\n");
+    }
+    printf("};\n\n");
+}
+
+int main(void)
+{
+    char name[64];
+
+    printf("/* Generated by tools/host-benchmark/gen_cmsis_q15_tables.cpp, do not edit */\n\n");
+    printf("#include \"edge-impulse-sdk/CMSIS/DSP/Include/arm_common_tables.h\"\n\n");
+
+    for (unsigned n = 16; n <= 4096; n *= 2) {
+        std::vector<int16_t> twiddle;
+        for (unsigned i = 0; i < 3 * n / 4; i++) {
+            twiddle.push_back(to_q15(std::cos(2 * pi * i / n)));
+            twiddle.push_back(to_q15(std::sin(2 * pi * i / n)));
+        }
+        snprintf(name, sizeof(name), "twiddleCoef_%u_q15", n);
+        print_q15(name, twiddle);
+
+        unsigned bits = 0;
+        while ((1U << bits) < n) {
+            bits++;
+        }
+        std::vector<uint16_t> bitrev;
+        for (unsigned i = 0; i < n; i++) {
+            unsigned r = 0;
+            for (unsigned b = 0; b < bits; b++) {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            if (i < r) {
+                bitrev.push_back((uint16_t)(i * 8));
+                bitrev.push_back((uint16_t)(r * 8));
+            }
+        }
+        snprintf(name, sizeof(name), "armBitRevIndexTable_fixed_%u", n);
+        print_u16(name, bitrev);
+    }
+
+    // 4096 complex coefficients, the RFFT of length n steps through them by 8192 / n
+    std::vector<int16_t> a, b;
+    for (unsigned i = 0; i < 4096; i++) {
+        const double angle = 2 * pi / 8192 * i;
+        a.push_back(to_q15(0.5 * (1.0 - std::sin(angle))));
+        a.push_back(to_q15(0.5 * -std::cos(angle)));
+        b.push_back(to_q15(0.5 * (1.0 + std::sin(angle))));
+        b.push_back(to_q15(0.5 * std::cos(angle)));
+    }
+    print_q15("realCoefAQ15", a);
+    print_q15("realCoefBQ15", b);
+
+    return 0;
+}
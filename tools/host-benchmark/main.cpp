@@ -0,0 +1,812 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host replay benchmark for the impulse in ei-model/. Replays recorded samples
+ * (CBOR files as written by ei_sampler.cpp, or comma separated feature files as
+ * used by firmware-sdk/tools/test_inference.py) through run_classifier or
+ * run_classifier_continuous and reports per-stage latency, heap allocations and
+ * peak memory as JSON. Built with Q15=1, --q15 also runs every window through the
+ * fixed point DSP blocks and reports how far they are from the float path.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#define heap_block_size(ptr) malloc_size(ptr)
+#else
+#include <malloc.h>
+#define heap_block_size(ptr) malloc_usable_size(ptr)
+#endif
+
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "edge-impulse-sdk/classifier/ei_inference_arena.h"
+#include "edge-impulse-sdk/classifier/ei_op_profile.h"
+#include "firmware-sdk/QCBOR/inc/qcbor.h"
+
+typedef struct {
+    std::string path;
+    std::vector<float> values; // frames of EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME values
+} sample_t;
+
+typedef struct {
+    uint64_t dsp_us;
+    uint64_t classification_us;
+    uint64_t anomaly_us;
+    uint64_t total_us;
+    uint32_t allocations;
+    size_t peak_bytes;
+} measurement_t;
+
+typedef struct {
+    uint32_t runs;
+    uint32_t warmup;
+    uint32_t stride;
+    bool continuous;
+    bool debug;
+    const char *output;
+    float q15_scale;            // units per count for --q15, 0 if off
+    float input_scale;          // quantization of the model input, for the int8 feature comparison
+    int32_t input_zero_point;
+} options_t;
+
+#if EI_CLASSIFIER_HAS_Q15_DSP == 1
+// fixed point vs float of one DSP block, over all windows
+typedef struct {
+    size_t block;
+    uint32_t features;
+    uint32_t identical_i8;
+    int32_t max_lsb;
+    float max_abs_diff;
+    std::vector<uint64_t> float_cycles;
+    std::vector<uint64_t> q15_cycles;
+} q15_block_t;
+
+static struct {
+    std::vector<q15_block_t> blocks;
+    uint32_t windows;
+    uint32_t same_label;
+    float max_score_diff;
+    float max_anomaly_diff;
+} q15_stats;
+#endif // EI_CLASSIFIER_HAS_Q15_DSP
+
+static struct {
+    uint32_t allocations;
+    size_t live_bytes;
+    size_t peak_bytes;              // since the start of the process
+    size_t inference_peak_bytes;    // since the start of the current inference, see measure()
+} heap_stats;
+
+/* Heap tracking ---------------------------------------------------------- */
+
+static void *track_alloc(void *ptr)
+{
+    if(ptr) {
+        heap_stats.allocations++;
+        heap_stats.live_bytes += heap_block_size(ptr);
+        heap_stats.peak_bytes = std::max(heap_stats.peak_bytes, heap_stats.live_bytes);
+        heap_stats.inference_peak_bytes = std::max(heap_stats.inference_peak_bytes, heap_stats.live_bytes);
+    }
+    return ptr;
+}
+
+static void track_free(void *ptr)
+{
+    if(ptr) {
+        heap_stats.live_bytes -= heap_block_size(ptr);
+        free(ptr);
+    }
+}
+
+// replace the weak porting/posix implementations, routed through the inference arena
+// like on the device (see porting/infineon-psoc62)
+void *ei_malloc(size_t size)
+{
+    void *mem = ei_inference_arena_try_malloc(size);
+
+    return mem ? mem : track_alloc(malloc(size));
+}
+
+void *ei_calloc(size_t nitems, size_t size)
+{
+    void *mem = ei_inference_arena_try_malloc(nitems * size);
+
+    if(mem) {
+        memset(mem, 0, nitems * size);
+        return mem;
+    }
+    return track_alloc(calloc(nitems, size));
+}
+
+void ei_free(void *ptr)
+{
+    if(!ei_inference_arena_free(ptr)) {
+        track_free(ptr);
+    }
+}
+
+void *operator new(size_t size)
+{
+    void *ptr = track_alloc(malloc(size));
+    if(!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    track_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    track_free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    track_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    track_free(ptr);
+}
+
+// keep stdout for the report
+void ei_printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// TSC ticks, i.e. cycles at the nominal clock
+uint32_t ei_op_profile_read_cycles(void)
+{
+    return (uint32_t)__rdtsc();
+}
+#endif
+
+/* Sample loading --------------------------------------------------------- */
+
+static bool read_file(const char *path, std::vector<uint8_t> &data)
+{
+    FILE *file = fopen(path, "rb");
+    if(!file) {
+        ei_printf("ERR: Cannot open %s\n", path);
+        return false;
+    }
+
+    uint8_t chunk[4096];
+    size_t read;
+    while((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + read);
+    }
+    fclose(file);
+    return true;
+}
+
+/**
+ * Comma separated values, hex encoded pixels when the file name contains "image"
+ * (same rules as test_inference.py)
+ */
+static bool load_features(sample_t *sample)
+{
+    std::vector<uint8_t> data;
+    if(!read_file(sample->path.c_str(), data)) {
+        return false;
+    }
+    data.push_back('\0');
+
+    const bool hex = sample->path.find("image") != std::string::npos;
+    const char *pos = (const char *)data.data();
+    while(*pos) {
+        char *end;
+        float value = hex ? (float)strtoul(pos, &end, 16) : strtof(pos, &end);
+        if(end == pos) {
+            ei_printf("ERR: Invalid value at offset %d in %s\n",
+                (int)(pos - (const char *)data.data()), sample->path.c_str());
+            return false;
+        }
+        sample->values.push_back(value);
+
+        pos = end;
+        while(*pos == ',' || *pos == ' ' || *pos == '\r' || *pos == '\n' || *pos == '\t') {
+            pos++;
+        }
+    }
+    return true;
+}
+
+/**
+ * Decode a sensor_aq CBOR document, i.e. a "payload" map holding "interval_ms",
+ * "sensors" and "values" (one number or an array per frame)
+ * @returns false if the document is incomplete
+ */
+static bool decode_cbor(const uint8_t *data, size_t size, sample_t *sample, uint32_t *axes, double *interval_ms)
+{
+    QCBORDecodeContext ctx;
+    UsefulBufC buffer = { data, size };
+    QCBORDecode_Init(&ctx, buffer, QCBOR_DECODE_MODE_NORMAL);
+
+    QCBORItem item;
+    int values_level = -1;
+    bool complete = false;
+
+    sample->values.clear();
+
+    // "values" is the last item the sampler writes, stop once it's closed
+    while(!complete && QCBORDecode_GetNext(&ctx, &item) == QCBOR_SUCCESS) {
+        if(values_level >= 0) {
+            if(item.uDataType == QCBOR_TYPE_DOUBLE) {
+                sample->values.push_back((float)item.val.dfnum);
+            }
+            else if(item.uDataType == QCBOR_TYPE_INT64) {
+                sample->values.push_back((float)item.val.int64);
+            }
+            complete = item.uNextNestLevel <= values_level;
+            continue;
+        }
+
+        if(item.uLabelType != QCBOR_TYPE_TEXT_STRING) {
+            continue;
+        }
+        const std::string label((const char *)item.label.string.ptr, item.label.string.len);
+        if(label == "interval_ms" && item.uDataType == QCBOR_TYPE_DOUBLE) {
+            *interval_ms = item.val.dfnum;
+        }
+        else if(label == "interval_ms" && item.uDataType == QCBOR_TYPE_INT64) {
+            *interval_ms = (double)item.val.int64;
+        }
+        else if(label == "sensors" && item.uDataType == QCBOR_TYPE_ARRAY) {
+            *axes = item.val.uCount;
+        }
+        else if(label == "values" && item.uDataType == QCBOR_TYPE_ARRAY) {
+            values_level = item.uNestingLevel;
+            complete = item.uNextNestLevel <= values_level;
+        }
+    }
+
+    return complete;
+}
+
+/**
+ * Sample file from the sampler (ei_sampler.cpp)
+ */
+static bool load_cbor(sample_t *sample)
+{
+    std::vector<uint8_t> data;
+    if(!read_file(sample->path.c_str(), data)) {
+        return false;
+    }
+
+    uint32_t axes = 0;
+    double interval_ms = 0;
+    size_t size = data.size();
+
+    // the sampler pads the flash with 0xFF past the end of the "values" array,
+    // so drop trailing 0xFF until the document decodes
+    while(!decode_cbor(data.data(), size, sample, &axes, &interval_ms)) {
+        if(size == 0 || data[size - 1] != 0xFF) {
+            ei_printf("ERR: %s is not a valid sample file\n", sample->path.c_str());
+            return false;
+        }
+        size--;
+    }
+
+    if(axes != EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
+        ei_printf("ERR: %s has %u axes, the impulse expects %d\n",
+            sample->path.c_str(), axes, EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME);
+        return false;
+    }
+    if(std::fabs(interval_ms - EI_CLASSIFIER_INTERVAL_MS) > 0.5) {
+        ei_printf("WARN: %s was sampled at %.2f ms, the impulse expects %.2f ms\n",
+            sample->path.c_str(), interval_ms, (double)EI_CLASSIFIER_INTERVAL_MS);
+    }
+    return true;
+}
+
+static bool load_sample(const char *path, sample_t *sample)
+{
+    sample->path = path;
+
+    const size_t len = strlen(path);
+    bool ret = (len > 5 && strcmp(path + len - 5, ".cbor") == 0) ? load_cbor(sample) : load_features(sample);
+    if(ret && sample->values.size() % EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME != 0) {
+        ei_printf("WARN: %s doesn't hold whole frames, dropping the last %d values\n",
+            path, (int)(sample->values.size() % EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME));
+        sample->values.resize(sample->values.size() - sample->values.size() % EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME);
+    }
+    return ret;
+}
+
+/* Benchmark -------------------------------------------------------------- */
+
+static bool measure(float *values, size_t values_size, const options_t *options, measurement_t *m)
+{
+    signal_t signal;
+    numpy::signal_from_buffer(values, values_size, &signal);
+
+    ei_impulse_result_t result = {};
+
+    heap_stats.allocations = 0;
+    heap_stats.inference_peak_bytes = heap_stats.live_bytes;
+    const size_t base_bytes = heap_stats.live_bytes;
+
+    uint64_t start_us = ei_read_timer_us();
+    EI_IMPULSE_ERROR res = options->continuous ?
+        run_classifier_continuous(&signal, &result, options->debug) :
+        run_classifier(&signal, &result, options->debug);
+    m->total_us = ei_read_timer_us() - start_us;
+
+    if(res != EI_IMPULSE_OK) {
+        ei_printf("ERR: Failed to run classifier (%d)\n", res);
+        return false;
+    }
+
+    m->dsp_us = result.timing.dsp_us;
+    m->classification_us = result.timing.classification_us;
+    m->anomaly_us = result.timing.anomaly_us;
+    m->allocations = heap_stats.allocations;
+    m->peak_bytes = heap_stats.inference_peak_bytes - base_bytes;
+    return true;
+}
+
+#if EI_CLASSIFIER_HAS_Q15_DSP == 1
+static uint64_t read_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return ei_read_timer_us();
+#endif
+}
+
+static int8_t quantize(float value, const options_t *options)
+{
+    int32_t v = (int32_t)lrintf(value / options->input_scale) + options->input_zero_point;
+    return (int8_t)std::min(127, std::max(-128, v));
+}
+
+static size_t top_label(const ei_impulse_result_t *result)
+{
+    size_t top = 0;
+    for(size_t ix = 1; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        if(result->classification[ix].value > result->classification[top].value) {
+            top = ix;
+        }
+    }
+    return top;
+}
+
+/**
+ * The window as counts (values / q15_scale), run through the fixed point DSP blocks and
+ * run_classifier_i16(), and converted back to float through the float blocks and run_classifier().
+ * Both see the same samples, like the float and the fixed point build on the device.
+ */
+static bool compare_q15(const float *values, size_t values_size, const options_t *options)
+{
+    const ei_impulse_t *impulse = ei_default_impulse.impulse;
+    std::vector<int16_t> counts(values_size);
+    std::vector<float> rounded(values_size);
+
+    for(size_t ix = 0; ix < values_size; ix++) {
+        long count = lrintf(values[ix] / options->q15_scale);
+        counts[ix] = (int16_t)std::min(32767L, std::max(-32768L, count));
+        rounded[ix] = counts[ix] * options->q15_scale;
+    }
+
+    signal_t signal;
+    numpy::signal_from_buffer(rounded.data(), values_size, &signal);
+    signal_i16_t signal_i16;
+    signal_i16.total_length = values_size;
+    signal_i16.scale = options->q15_scale;
+    signal_i16.get_data = [&counts](size_t offset, size_t length, int16_t *out_ptr) {
+        memcpy(out_ptr, &counts[offset], length * sizeof(int16_t));
+        return 0;
+    };
+
+    for(size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
+        ei_model_dsp_t block = impulse->dsp_blocks[ix];
+        extract_fn_q15_t extract_fn_q15 = get_extract_fn_q15(impulse, &block);
+        if(!extract_fn_q15) {
+            continue;
+        }
+
+        auto stats = std::find_if(q15_stats.blocks.begin(), q15_stats.blocks.end(),
+            [ix](const q15_block_t &b) { return b.block == ix; });
+        if(stats == q15_stats.blocks.end()) {
+            q15_stats.blocks.push_back(q15_block_t { ix, 0, 0, 0, 0.0f, {}, {} });
+            stats = q15_stats.blocks.end() - 1;
+        }
+
+        matrix_t float_features(1, block.n_output_features);
+        matrix_t q15_features(1, block.n_output_features);
+        SignalWithAxes swa(&signal, block.axes, block.axes_size, impulse);
+
+        uint64_t start = read_cycles();
+        int ret = block.extract_fn(swa.get_signal(), &float_features, block.config, impulse->frequency);
+        stats->float_cycles.push_back(read_cycles() - start);
+        if(ret != EIDSP_OK) {
+            ei_printf("ERR: Failed to run DSP block %d in float (%d)\n", (int)ix, ret);
+            return false;
+        }
+
+        start = read_cycles();
+        ret = extract_fn_q15(&signal_i16, &q15_features, block.config, impulse->frequency);
+        stats->q15_cycles.push_back(read_cycles() - start);
+        if(ret != EIDSP_OK) {
+            ei_printf("ERR: Failed to run DSP block %d in fixed point (%d)\n", (int)ix, ret);
+            return false;
+        }
+
+        for(size_t f = 0; f < block.n_output_features; f++) {
+            const float a = float_features.buffer[f];
+            const float b = q15_features.buffer[f];
+            stats->features++;
+            stats->max_abs_diff = std::max(stats->max_abs_diff, std::fabs(a - b));
+            if(options->input_scale > 0.0f) {
+                int32_t lsb = std::abs((int32_t)quantize(a, options) - (int32_t)quantize(b, options));
+                stats->identical_i8 += lsb == 0;
+                stats->max_lsb = std::max(stats->max_lsb, lsb);
+            }
+        }
+    }
+
+    ei_impulse_result_t float_result = {};
+    ei_impulse_result_t q15_result = {};
+    if(run_classifier(&signal, &float_result, false) != EI_IMPULSE_OK ||
+       run_classifier_i16(&signal_i16, &q15_result, false) != EI_IMPULSE_OK) {
+        ei_printf("ERR: Failed to run classifier\n");
+        return false;
+    }
+
+    q15_stats.windows++;
+    q15_stats.same_label += top_label(&float_result) == top_label(&q15_result);
+    for(size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        q15_stats.max_score_diff = std::max(q15_stats.max_score_diff,
+            std::fabs(float_result.classification[ix].value - q15_result.classification[ix].value));
+    }
+    q15_stats.max_anomaly_diff = std::max(q15_stats.max_anomaly_diff,
+        std::fabs(float_result.anomaly - q15_result.anomaly));
+    return true;
+}
+#endif // EI_CLASSIFIER_HAS_Q15_DSP
+
+static bool run_sample(sample_t *sample, const options_t *options, std::vector<measurement_t> &measurements)
+{
+    const size_t window = options->continuous ?
+        EI_CLASSIFIER_SLICE_SIZE * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME :
+        EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+    const size_t stride = options->continuous || options->stride == 0 ?
+        window :
+        options->stride * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+
+    if(sample->values.size() < window) {
+        ei_printf("ERR: %s holds %d values, need at least %d\n",
+            sample->path.c_str(), (int)sample->values.size(), (int)window);
+        return false;
+    }
+
+    for(uint32_t run = 0; run < options->runs; run++) {
+        if(options->continuous) {
+            // every replay is a new stream
+            run_classifier_init();
+        }
+        for(size_t offset = 0; offset + window <= sample->values.size(); offset += stride) {
+            measurement_t m;
+            if(!measure(&sample->values[offset], window, options, &m)) {
+                return false;
+            }
+            measurements.push_back(m);
+            if(measurements.size() == options->warmup) {
+                ei_op_profile_reset();
+            }
+#if EI_CLASSIFIER_HAS_Q15_DSP == 1
+            if(options->q15_scale > 0.0f && !compare_q15(&sample->values[offset], window, options)) {
+                return false;
+            }
+#endif
+        }
+    }
+    return true;
+}
+
+/* Report ----------------------------------------------------------------- */
+
+static uint64_t percentile(std::vector<uint64_t> values, uint32_t pct)
+{
+    if(values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t rank = (size_t)std::ceil(pct / 100.0 * values.size());
+    return values[rank > 0 ? rank - 1 : 0];
+}
+
+template <typename T>
+static void print_stat(FILE *out, const char *name, const std::vector<measurement_t> &measurements, T measurement_t::*field, bool last)
+{
+    std::vector<uint64_t> values;
+    for(const measurement_t &m : measurements) {
+        values.push_back((uint64_t)(m.*field));
+    }
+    fprintf(out, "    \"%s\": { \"p50\": %llu, \"p99\": %llu, \"max\": %llu }%s\n", name,
+        (unsigned long long)percentile(values, 50), (unsigned long long)percentile(values, 99),
+        (unsigned long long)percentile(values, 100), last ? "" : ",");
+}
+
+static void print_string(FILE *out, const std::string &str)
+{
+    fputc('"', out);
+    for(char c : str) {
+        if(c == '"' || c == '\\') {
+            fputc('\\', out);
+        }
+        fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+static void print_op_profile(FILE *out)
+{
+    const ei_op_profile_entry_t *ops;
+    ei_op_profile_invoke_t invoke;
+    size_t ops_count = ei_op_profile_get(&ops, &invoke);
+    uint32_t invokes = invoke.invokes > 0 ? invoke.invokes : 1;
+
+    // averages per call
+    fprintf(out, "  \"ops\": {\n");
+    fprintf(out, "    \"invoke\": { \"calls\": %u, \"cycles\": %llu, \"time_us\": %llu },\n",
+        invoke.invokes, (unsigned long long)(invoke.cycles / invokes),
+        (unsigned long long)(invoke.time_us / invokes));
+    fprintf(out, "    \"layers\": [\n");
+    for(size_t ix = 0; ix < ops_count; ix++) {
+        uint32_t calls = ops[ix].calls > 0 ? ops[ix].calls : 1;
+        fprintf(out, "      { \"index\": %u, \"op\": \"%s\", \"calls\": %u, \"cycles\": %llu, \"time_us\": %llu, "
+            "\"macs\": %u, \"arena_bytes\": %u }%s\n",
+            (uint32_t)ix, ops[ix].name ? ops[ix].name : "?", ops[ix].calls,
+            (unsigned long long)(ops[ix].cycles / calls), (unsigned long long)(ops[ix].time_us / calls),
+            ops[ix].macs, ops[ix].arena_bytes, ix + 1 < ops_count ? "," : "");
+    }
+    fprintf(out, "    ]\n");
+    fprintf(out, "  },\n");
+}
+#endif // EI_CLASSIFIER_PROFILE_OPS
+
+#if EI_CLASSIFIER_HAS_Q15_DSP == 1
+static void print_q15(FILE *out, const options_t *options)
+{
+    fprintf(out, "  \"q15\": {\n");
+    fprintf(out, "    \"scale\": %g,\n", (double)options->q15_scale);
+    fprintf(out, "    \"windows\": %u,\n", q15_stats.windows);
+    fprintf(out, "    \"same_top_label\": %u,\n", q15_stats.same_label);
+    fprintf(out, "    \"max_score_diff\": %.6f,\n", (double)q15_stats.max_score_diff);
+    fprintf(out, "    \"max_anomaly_diff\": %.6f,\n", (double)q15_stats.max_anomaly_diff);
+    fprintf(out, "    \"blocks\": [\n");
+    for(size_t ix = 0; ix < q15_stats.blocks.size(); ix++) {
+        const q15_block_t &b = q15_stats.blocks[ix];
+        fprintf(out, "      { \"block\": %u, \"features\": %u, \"max_abs_diff\": %.6f, ",
+            (uint32_t)b.block, b.features, (double)b.max_abs_diff);
+        if(options->input_scale > 0.0f) {
+            fprintf(out, "\"identical_i8\": %u, \"max_lsb\": %d, ", b.identical_i8, b.max_lsb);
+        }
+        fprintf(out, "\"float_cycles_p50\": %llu, \"q15_cycles_p50\": %llu }%s\n",
+            (unsigned long long)percentile(b.float_cycles, 50), (unsigned long long)percentile(b.q15_cycles, 50),
+            ix + 1 < q15_stats.blocks.size() ? "," : "");
+    }
+    fprintf(out, "    ]\n");
+    fprintf(out, "  },\n");
+}
+#endif // EI_CLASSIFIER_HAS_Q15_DSP
+
+static void print_report(FILE *out, const options_t *options, const std::vector<sample_t> &samples,
+    const std::vector<measurement_t> &measurements)
+{
+    ei_inference_arena_stats_t arena;
+    ei_inference_arena_get_stats(&arena);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"project\": { \"name\": ");
+    print_string(out, EI_CLASSIFIER_PROJECT_NAME);
+    fprintf(out, ", \"id\": %d, \"deploy_version\": %d },\n",
+        EI_CLASSIFIER_PROJECT_ID, EI_CLASSIFIER_PROJECT_DEPLOY_VERSION);
+    fprintf(out, "  \"mode\": \"%s\",\n", options->continuous ? "continuous" : "single");
+    fprintf(out, "  \"runs\": %u,\n", options->runs);
+    fprintf(out, "  \"samples\": [");
+    for(size_t ix = 0; ix < samples.size(); ix++) {
+        print_string(out, samples[ix].path);
+        fprintf(out, ix + 1 < samples.size() ? ", " : "");
+    }
+    fprintf(out, "],\n");
+    fprintf(out, "  \"inferences\": %u,\n", (uint32_t)measurements.size());
+    fprintf(out, "  \"latency_us\": {\n");
+    print_stat(out, "dsp", measurements, &measurement_t::dsp_us, false);
+    print_stat(out, "classification", measurements, &measurement_t::classification_us, false);
+    print_stat(out, "anomaly", measurements, &measurement_t::anomaly_us, false);
+    print_stat(out, "total", measurements, &measurement_t::total_us, true);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"per_inference\": {\n");
+    print_stat(out, "heap_allocations", measurements, &measurement_t::allocations, false);
+    print_stat(out, "heap_peak_bytes", measurements, &measurement_t::peak_bytes, true);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"arena\": { \"size\": %u, \"high_water_mark\": %u, \"heap_fallbacks\": %u },\n",
+        (uint32_t)arena.size, (uint32_t)arena.high_water_mark, (uint32_t)arena.heap_fallbacks);
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    print_op_profile(out);
+#endif
+#if EI_CLASSIFIER_HAS_Q15_DSP == 1
+    if(options->q15_scale > 0.0f) {
+        print_q15(out, options);
+    }
+#endif
+    fprintf(out, "  \"heap_peak_bytes\": %u,\n", (uint32_t)heap_stats.peak_bytes);
+    fprintf(out, "  \"max_rss_kb\": %ld\n", usage.ru_maxrss);
+    fprintf(out, "}\n");
+}
+
+static void print_usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s [options] <sample.cbor|features.txt>...\n"
+        "  --runs N         replay every sample N times (default 10)\n"
+        "  --warmup N       leave the first N inferences out of the report (default 1)\n"
+        "  --stride N       samples between two windows (default: one window)\n"
+        "  --continuous     feed slices to run_classifier_continuous instead\n"
+        "  --debug          print the classifier debug output on stderr\n"
+        "  --output FILE    write the JSON report to FILE instead of stdout\n"
+        "  --q15 SCALE      compare the fixed point DSP with the float path on counts = value / SCALE (Q15=1 build)\n"
+        "  --input-quant SCALE,ZERO_POINT\n"
+        "                   model input quantization, --q15 then also compares the features as int8\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    options_t options = { 10, 1, 0, false, false, NULL, 0.0f, 0.0f, 0 };
+    std::vector<sample_t> samples;
+
+    for(int ix = 1; ix < argc; ix++) {
+        const char *arg = argv[ix];
+        const bool has_value = ix + 1 < argc;
+
+        if(strcmp(arg, "--runs") == 0 && has_value) {
+            options.runs = atoi(argv[++ix]);
+        }
+        else if(strcmp(arg, "--warmup") == 0 && has_value) {
+            options.warmup = atoi(argv[++ix]);
+        }
+        else if(strcmp(arg, "--stride") == 0 && has_value) {
+            options.stride = atoi(argv[++ix]);
+        }
+        else if(strcmp(arg, "--continuous") == 0) {
+            options.continuous = true;
+        }
+        else if(strcmp(arg, "--debug") == 0) {
+            options.debug = true;
+        }
+        else if(strcmp(arg, "--output") == 0 && has_value) {
+            options.output = argv[++ix];
+        }
+        else if(strcmp(arg, "--q15") == 0 && has_value) {
+            options.q15_scale = strtof(argv[++ix], NULL);
+        }
+        else if(strcmp(arg, "--input-quant") == 0 && has_value) {
+            char *end;
+            options.input_scale = strtof(argv[++ix], &end);
+            options.input_zero_point = *end == ',' ? atoi(end + 1) : 0;
+        }
+        else if(arg[0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        }
+        else {
+            sample_t sample;
+            if(!load_sample(arg, &sample)) {
+                return 1;
+            }
+            samples.push_back(sample);
+        }
+    }
+
+    if(samples.empty() || options.runs == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+#if EI_CLASSIFIER_HAS_Q15_DSP == 1
+    if(options.q15_scale > 0.0f && options.continuous) {
+        ei_printf("ERR: --q15 compares single windows, it can't be used with --continuous\n");
+        return 1;
+    }
+#else
+    if(options.q15_scale > 0.0f) {
+        ei_printf("ERR: --q15 needs the fixed point DSP, build with make Q15=1\n");
+        return 1;
+    }
+#endif
+
+    std::vector<measurement_t> measurements;
+    if(options.warmup == 0) {
+        // run_sample() only resets the op profile once the warm-up is done
+        ei_op_profile_reset();
+    }
+    for(sample_t &sample : samples) {
+        if(!run_sample(&sample, &options, measurements)) {
+            return 1;
+        }
+    }
+
+    if(measurements.size() <= options.warmup) {
+        ei_printf("ERR: Only %u inferences, all of them warm-up\n", (uint32_t)measurements.size());
+        return 1;
+    }
+    measurements.erase(measurements.begin(), measurements.begin() + options.warmup);
+
+    FILE *out = options.output ? fopen(options.output, "w") : stdout;
+    if(!out) {
+        ei_printf("ERR: Cannot open %s\n", options.output);
+        return 1;
+    }
+    print_report(out, &options, samples, measurements);
+    if(out != stdout) {
+        fclose(out);
+    }
+
+    return 0;
+}
@@ -0,0 +1,231 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Generates the sparse mel filterbanks of MFE / MFCC blocks as const tables, so they
+ * live in flash instead of being computed at runtime. Compile the output into the
+ * firmware and build with EIDSP_MEL_FILTERBANK_CONST_TABLES=1.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "edge-impulse-sdk/dsp/speechpy/mel_filterbank.hpp"
+
+using namespace ei;
+using namespace ei::speechpy;
+
+typedef struct {
+    const char *spec;
+    mel_filterbank_t filterbank;
+    std::vector<uint8_t> mem;
+} table_t;
+
+static void print_usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s [--output FILE] <block,version,frequency,fft_length,num_filters[,low_frequency,high_frequency]>...\n"
+        "  block            mfe or mfcc\n"
+        "  version          implementation version of the block\n"
+        "  frequency        sampling frequency of the impulse (Hz)\n"
+        "  low/high         band edges as in the DSP config, 0 (default) for the block's default\n"
+        "  --output FILE    write the tables to FILE instead of stdout\n"
+        "e.g. %s mfe,4,16000,512,40 mfcc,4,16000,256,32,300,0 > ei_mel_filterbank_tables.cpp\n",
+        name, name);
+}
+
+/**
+ * Parse a block spec and compute its filterbank, with the same dispatch as
+ * extract_mfe_features / extract_mfcc_features in classifier/ei_run_dsp.h
+ */
+static bool create_table(const char *spec, table_t *table)
+{
+    char block[8] = { 0 };
+    unsigned version = 0, frequency = 0, fft_length = 0, num_filters = 0, low = 0, high = 0;
+    int fields = sscanf(spec, "%7[a-z],%u,%u,%u,%u,%u,%u",
+        block, &version, &frequency, &fft_length, &num_filters, &low, &high);
+    if(fields != 5 && fields != 7) {
+        fprintf(stderr, "ERR: Cannot parse '%s'\n", spec);
+        return false;
+    }
+
+    mel_filterbank_t &filterbank = table->filterbank;
+    memset(&filterbank, 0, sizeof(filterbank));
+    if(strcmp(block, "mfcc") == 0) {
+        filterbank.type = MEL_FILTERBANK_TRIANGLE;
+    }
+    else if(strcmp(block, "mfe") == 0) {
+        filterbank.type = version > 2 ? MEL_FILTERBANK_TRIANGLE : MEL_FILTERBANK_SPEECHPY;
+    }
+    else {
+        fprintf(stderr, "ERR: Unknown block '%s' in '%s'\n", block, spec);
+        return false;
+    }
+    filterbank.version = version;
+    filterbank.sampling_frequency = frequency;
+    filterbank.fft_length = fft_length;
+    filterbank.num_filters = num_filters;
+    filterbank.low_frequency = low;
+    filterbank.high_frequency = high;
+    mel_filterbank::resolve_config(&filterbank);
+
+    size_t mem_size = 0;
+    int ret = mel_filterbank::get_mem_size(&filterbank, &mem_size);
+    if(ret == EIDSP_OK) {
+        table->mem.resize(mem_size);
+        ret = mel_filterbank::create(&filterbank, table->mem.data(), mem_size);
+    }
+    if(ret != EIDSP_OK) {
+        fprintf(stderr, "ERR: Failed to create the filterbank of '%s' (%d)\n", spec, ret);
+        return false;
+    }
+
+    table->spec = spec;
+    return true;
+}
+
+static void print_u16_array(FILE *out, const char *name, size_t ix, const uint16_t *values, size_t count)
+{
+    fprintf(out, "static const uint16_t ei_mel_filterbank_%u_%s[%u] = {", (unsigned)ix, name, (unsigned)count);
+    for(size_t jx = 0; jx < count; jx++) {
+        fprintf(out, "%s%u", jx % 16 == 0 ? "\n    " : " ", values[jx]);
+        if(jx + 1 < count) {
+            fprintf(out, ",");
+        }
+    }
+    fprintf(out, "\n};\n");
+}
+
+static void print_tables(FILE *out, std::vector<table_t> &tables)
+{
+    fprintf(out, "// Generated by tools/mel-filterbank:");
+    for(table_t &table : tables) {
+        fprintf(out, " %s", table.spec);
+    }
+    fprintf(out, "\n// Build with EIDSP_MEL_FILTERBANK_CONST_TABLES=1\n\n");
+    fprintf(out, "#include \"edge-impulse-sdk/dsp/speechpy/mel_filterbank.hpp\"\n\n");
+    fprintf(out, "#if EIDSP_MEL_FILTERBANK_CONST_TABLES == 1\n\n");
+
+    for(size_t ix = 0; ix < tables.size(); ix++) {
+        const mel_filterbank_t &filterbank = tables[ix].filterbank;
+
+        // MFE v1 / v2 weights depend on the quantization of the filterbank
+        if(filterbank.type == MEL_FILTERBANK_SPEECHPY) {
+            fprintf(out, "#if EIDSP_QUANTIZE_FILTERBANK != %d\n", EIDSP_QUANTIZE_FILTERBANK);
+            fprintf(out, "#error \"%s was generated with EIDSP_QUANTIZE_FILTERBANK=%d\"\n",
+                tables[ix].spec, EIDSP_QUANTIZE_FILTERBANK);
+            fprintf(out, "#endif\n\n");
+        }
+
+        size_t weights_count = 0;
+        for(size_t jx = 0; jx < filterbank.num_filters; jx++) {
+            weights_count += filterbank.bin_count[jx];
+        }
+
+        print_u16_array(out, "bin_start", ix, filterbank.bin_start, filterbank.num_filters);
+        print_u16_array(out, "bin_count", ix, filterbank.bin_count, filterbank.num_filters);
+
+        // 9 significant digits round trip a float exactly
+        fprintf(out, "static const float ei_mel_filterbank_%u_weights[%u] = {", (unsigned)ix, (unsigned)weights_count);
+        for(size_t jx = 0; jx < weights_count; jx++) {
+            fprintf(out, "%s%.9ef", jx % 6 == 0 ? "\n    " : " ", filterbank.weights[jx]);
+            if(jx + 1 < weights_count) {
+                fprintf(out, ",");
+            }
+        }
+        fprintf(out, "\n};\n\n");
+    }
+
+    fprintf(out, "const ei::speechpy::mel_filterbank_t ei_mel_filterbank_tables[] = {\n");
+    for(size_t ix = 0; ix < tables.size(); ix++) {
+        const mel_filterbank_t &filterbank = tables[ix].filterbank;
+        fprintf(out, "    { // %s\n", tables[ix].spec);
+        fprintf(out, "        %s, %u, %u, %u, %u, %u, %u,\n",
+            filterbank.type == MEL_FILTERBANK_TRIANGLE ?
+                "ei::speechpy::MEL_FILTERBANK_TRIANGLE" : "ei::speechpy::MEL_FILTERBANK_SPEECHPY",
+            filterbank.version, (unsigned)filterbank.sampling_frequency,
+            (unsigned)filterbank.low_frequency, (unsigned)filterbank.high_frequency,
+            filterbank.fft_length, filterbank.num_filters);
+        fprintf(out, "        ei_mel_filterbank_%u_bin_start, ei_mel_filterbank_%u_bin_count, ei_mel_filterbank_%u_weights\n",
+            (unsigned)ix, (unsigned)ix, (unsigned)ix);
+        fprintf(out, "    },\n");
+    }
+    fprintf(out, "};\n");
+    fprintf(out, "const size_t ei_mel_filterbank_tables_size = %u;\n\n", (unsigned)tables.size());
+    fprintf(out, "#endif // EIDSP_MEL_FILTERBANK_CONST_TABLES\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *output = NULL;
+    std::vector<table_t> tables;
+
+    for(int ix = 1; ix < argc; ix++) {
+        const char *arg = argv[ix];
+
+        if(strcmp(arg, "--output") == 0 && ix + 1 < argc) {
+            output = argv[++ix];
+        }
+        else if(arg[0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        }
+        else {
+            tables.emplace_back();
+            if(!create_table(arg, &tables.back())) {
+                return 1;
+            }
+        }
+    }
+
+    if(tables.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if(!out) {
+        fprintf(stderr, "ERR: Cannot open %s\n", output);
+        return 1;
+    }
+
+    print_tables(out, tables);
+
+    if(output) {
+        fclose(out);
+    }
+    return 0;
+}
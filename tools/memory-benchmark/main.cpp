@@ -0,0 +1,288 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Sample write throughput of EiDeviceMemory on a file-backed memory, with and
+ * without the page write-back cache (enable_page_cache). The memory splits
+ * writes at program page boundaries like EiFlashMemory, counts the program
+ * commands it issues and can charge a fixed cost per command, the part of a
+ * QSPI NOR write that doesn't depend on its length.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "firmware-sdk/ei_device_memory.h"
+
+#define MEMORY_BLOCK_SIZE   0x40000     // 256K sector, as the PSoC62 QSPI flash
+#define MEMORY_PAGE_SIZE    0x0200      // 512 byte program page
+
+typedef struct {
+    uint32_t size;
+    uint32_t command_us;
+    const char *path;
+} options_t;
+
+class EiDeviceFile : public EiDeviceMemory {
+private:
+    int fd;
+    uint8_t page_buffer[MEMORY_PAGE_SIZE];
+
+    static void busy_wait_us(uint32_t us)
+    {
+        if(us == 0) {
+            return;
+        }
+        auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+        while(std::chrono::steady_clock::now() < end) {
+        }
+    }
+
+    uint32_t program(const uint8_t *data, uint32_t address, uint32_t num_bytes)
+    {
+        program_commands++;
+        busy_wait_us(command_us);
+        return pwrite(fd, data, num_bytes, address) == (ssize_t)num_bytes ? num_bytes : 0;
+    }
+
+protected:
+    uint32_t read_data(uint8_t *data, uint32_t address, uint32_t num_bytes) override
+    {
+        ssize_t ret = pread(fd, data, num_bytes, address);
+        return ret < 0 ? 0 : (uint32_t)ret;
+    }
+
+    // one program command per page touched, like EiFlashMemory::write_data()
+    uint32_t write_data(const uint8_t *data, uint32_t address, uint32_t num_bytes) override
+    {
+        uint32_t written = 0;
+
+        write_calls++;
+        while(written < num_bytes) {
+            uint32_t chunk = MEMORY_PAGE_SIZE - ((address + written) % MEMORY_PAGE_SIZE);
+            if(chunk > num_bytes - written) {
+                chunk = num_bytes - written;
+            }
+            if(program(data + written, address + written, chunk) != chunk) {
+                break;
+            }
+            written += chunk;
+        }
+
+        return written;
+    }
+
+    uint32_t erase_data(uint32_t address, uint32_t num_bytes) override
+    {
+        std::vector<uint8_t> erased(num_bytes, 0xff);
+        return pwrite(fd, erased.data(), num_bytes, address) == (ssize_t)num_bytes ? num_bytes : 0;
+    }
+
+public:
+    uint32_t command_us;
+    uint32_t write_calls;
+    uint32_t program_commands;
+
+    EiDeviceFile(int fd, uint32_t size, uint32_t command_us, bool page_cache)
+        : EiDeviceMemory(0, 0, size, MEMORY_BLOCK_SIZE)
+        , fd(fd)
+        , command_us(command_us)
+        , write_calls(0)
+        , program_commands(0)
+    {
+        if(page_cache) {
+            enable_page_cache(page_buffer, sizeof(page_buffer));
+        }
+    }
+};
+
+/* Workloads, every one writes `size` bytes -------------------------------- */
+
+typedef struct {
+    const char *name;
+    const char *description;
+} workload_t;
+
+static const workload_t workloads[] = {
+    { "cbor", "4 byte writes, as ei_write() gets them from the CBOR encoder" },
+    { "frames", "37 byte writes, one encoded 3-axis frame each" },
+    { "audio", "1024 byte writes at page aligned addresses, as the microphone writer" },
+    { "mixed", "1..600 byte writes, every 64th one skips ahead (non-contiguous)" },
+};
+
+static uint32_t next_random(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+/**
+ * Run one workload, mirror every write into `expected` so the memory can be checked afterwards
+ */
+static void run_workload(const workload_t *workload, EiDeviceMemory *memory,
+    uint32_t size, std::vector<uint8_t> &expected)
+{
+    std::vector<uint8_t> data(1024);
+    uint32_t random = 1;
+    uint32_t address = 0;
+
+    while(address < size) {
+        uint32_t length;
+
+        if(strcmp(workload->name, "cbor") == 0) {
+            length = 4;
+        }
+        else if(strcmp(workload->name, "frames") == 0) {
+            length = 37;
+        }
+        else if(strcmp(workload->name, "audio") == 0) {
+            length = 1024;
+        }
+        else {
+            length = 1 + next_random(&random) % 600;
+            if(next_random(&random) % 64 == 0) {
+                address += next_random(&random) % 64;
+            }
+        }
+
+        if(length > size - address) {
+            break;
+        }
+
+        for(uint32_t ix = 0; ix < length; ix++) {
+            data[ix] = (uint8_t)next_random(&random);
+        }
+        memory->write_sample_data(data.data(), address, length);
+        memcpy(&expected[address], data.data(), length);
+        address += length;
+    }
+
+    memory->finalize_samplig();
+}
+
+static bool run(const options_t *options, const workload_t *workload, bool page_cache, bool last)
+{
+    int fd = open(options->path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+        fprintf(stderr, "ERR: Cannot open %s\n", options->path);
+        return false;
+    }
+
+    EiDeviceFile memory(fd, options->size, options->command_us, page_cache);
+    std::vector<uint8_t> expected(options->size, 0xff);
+    memory.erase_sample_data(0, options->size);
+
+    auto start = std::chrono::steady_clock::now();
+    run_workload(workload, &memory, options->size, expected);
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::vector<uint8_t> actual(options->size);
+    bool ok = memory.read_sample_data(actual.data(), 0, options->size) == options->size &&
+        memcmp(actual.data(), expected.data(), options->size) == 0;
+    close(fd);
+
+    printf("    { \"workload\": \"%s\", \"page_cache\": %s, \"write_calls\": %u, \"program_commands\": %u, "
+        "\"time_ms\": %.1f, \"mb_per_s\": %.2f, \"verified\": %s }%s\n",
+        workload->name, page_cache ? "true" : "false", memory.write_calls, memory.program_commands,
+        seconds * 1000.0, options->size / seconds / 1e6, ok ? "true" : "false", last ? "" : ",");
+
+    if(!ok) {
+        fprintf(stderr, "ERR: %s (page cache %s) read back different data\n",
+            workload->name, page_cache ? "on" : "off");
+    }
+    return ok;
+}
+
+static void print_usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --size BYTES      bytes written per workload (default 1048576)\n"
+        "  --command-us N    fixed cost of every program command in us (default 0)\n"
+        "  --file PATH       backing file (default memory-benchmark.bin)\n"
+        "Workloads:\n",
+        name);
+    for(const workload_t &workload : workloads) {
+        fprintf(stderr, "  %-8s %s\n", workload.name, workload.description);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    options_t options = { 1024 * 1024, 0, "memory-benchmark.bin" };
+
+    for(int ix = 1; ix < argc; ix++) {
+        const char *arg = argv[ix];
+        const bool has_value = ix + 1 < argc;
+
+        if(strcmp(arg, "--size") == 0 && has_value) {
+            options.size = strtoul(argv[++ix], NULL, 0);
+        }
+        else if(strcmp(arg, "--command-us") == 0 && has_value) {
+            options.command_us = strtoul(argv[++ix], NULL, 0);
+        }
+        else if(strcmp(arg, "--file") == 0 && has_value) {
+            options.path = argv[++ix];
+        }
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(options.size == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    const size_t workload_count = sizeof(workloads) / sizeof(workloads[0]);
+
+    printf("{\n  \"size\": %u,\n  \"command_us\": %u,\n  \"results\": [\n", options.size, options.command_us);
+    for(size_t ix = 0; ix < workload_count; ix++) {
+        ok &= run(&options, &workloads[ix], false, false);
+        ok &= run(&options, &workloads[ix], true, ix + 1 == workload_count);
+    }
+    printf("  ]\n}\n");
+
+    unlink(options.path);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+""" Adds the per-op profile hooks (EI_CLASSIFIER_PROFILE_OPS) to an EON compiled model.
+Run it again after every export of ei-model/, the generated source doesn't have them. """
+
+import os
+import re
+import sys
+import argparse
+
+MARKER = "ei_op_profile.h"
+
+PORTING_INCLUDE = '#include "edge-impulse-sdk/porting/ei_classifier_porting.h"\n'
+PROFILE_INCLUDE = '#include "edge-impulse-sdk/classifier/ei_op_profile.h"\n'
+
+REGISTRATION = re.compile(r"^([ \t]*)registrations\[(OP_\w+)\] = Register_(\w+)\(\);\n", re.M)
+INVOKE = re.compile(r"^([ \t]*)TfLiteStatus status = registrations\[used_ops\[i\]\]\.invoke\(&ctx, &tflNodes\[i\]\);\n", re.M)
+
+SCHEMA = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                      "../../ei-model/edge-impulse-sdk/tensorflow/lite/schema/schema_generated.h")
+
+
+def builtin_operators(schema):
+    with open(schema) as f:
+        return set(re.findall(r"^\s*BuiltinOperator_(\w+) = -?\d+,", f.read(), re.M))
+
+
+def builtin_name(register_name, builtins):
+    """ Register_FULLY_CONNECTED_INT8 -> FULLY_CONNECTED, None for custom ops """
+    name = register_name
+    while name:
+        if name in builtins:
+            return name
+        if "_" not in name:
+            break
+        name = name.rsplit("_", 1)[0]
+    return None
+
+
+def patch(source, builtins):
+    if MARKER in source:
+        return source, "already patched"
+
+    if PORTING_INCLUDE not in source:
+        raise ValueError("porting include not found")
+    source = source.replace(PORTING_INCLUDE, PORTING_INCLUDE + PROFILE_INCLUDE, 1)
+
+    registrations = list(REGISTRATION.finditer(source))
+    if not registrations:
+        raise ValueError("no op registrations found")
+    indent = registrations[-1].group(1)
+    lines = ["#if EI_CLASSIFIER_PROFILE_OPS == 1\n"]
+    for m in registrations:
+        op, register_name = m.group(2), m.group(3)
+        builtin = builtin_name(register_name, builtins)
+        if builtin:
+            lines.append("{}registrations[{}].builtin_code = BuiltinOperator_{};\n".format(indent, op, builtin))
+        else:
+            lines.append("{}registrations[{}].builtin_code = BuiltinOperator_CUSTOM;\n".format(indent, op))
+            lines.append('{}registrations[{}].custom_name = "{}";\n'.format(indent, op, register_name))
+    lines.append("#endif\n")
+    end = registrations[-1].end()
+    source = source[:end] + "".join(lines) + source[end:]
+
+    invoke = INVOKE.search(source)
+    if not invoke:
+        raise ValueError("invoke loop not found")
+    indent = invoke.group(1)
+    hook = ("#if EI_CLASSIFIER_PROFILE_OPS == 1\n"
+            "{0}TfLiteStatus status = ei_op_profile_invoke(&ctx, &tflNodes[i], &registrations[used_ops[i]], i);\n"
+            "#else\n"
+            "{1}"
+            "#endif\n").format(indent, invoke.group(0))
+    source = source[:invoke.start()] + hook + source[invoke.end():]
+
+    return source, "patched {} ops".format(len(registrations))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Add the per-op profile hooks to an EON compiled model")
+    parser.add_argument("sources", nargs="+", help="compiled model, e.g. ei-model/tflite-model/*_compiled.cpp")
+    parser.add_argument("--schema", default=SCHEMA, help="schema_generated.h with the BuiltinOperator names")
+    args = parser.parse_args()
+
+    builtins = builtin_operators(args.schema)
+    for path in args.sources:
+        with open(path) as f:
+            source = f.read()
+        try:
+            source, status = patch(source, builtins)
+        except ValueError as e:
+            print("{}: {}, is this an EON compiled model?".format(path, e))
+            sys.exit(1)
+        with open(path, "w") as f:
+            f.write(source)
+        print("{}: {}".format(path, status))
@@ -0,0 +1,371 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Size and encode time per frame of the sensor_aq float encodings, on
+ * synthetic 3-axis accelerometer data converted from raw counts the same way
+ * src/ei_inertial_sensor.cpp does. The values are decoded again to report the
+ * error each encoding introduces.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_CYCLE_COUNTER   1
+#endif
+
+#include "firmware-sdk/sensor-aq/sensor_aq.h"
+#include "firmware-sdk/sensor-aq/sensor_aq_none.h"
+extern "C" {
+#include "firmware-sdk/QCBOR/src/ieee754.h"
+}
+
+#define AXES                3
+#define IMU_SCALING_CONST   (16384.0)   // +-2g, as src/ei_inertial_sensor.cpp
+#define CONVERT_G_TO_MS2    9.80665f
+
+typedef enum {
+    MODE_ADD_DATA,
+    MODE_COMPACT,
+    MODE_FRAMES,
+    MODE_FRAMES_I16
+} encode_mode_t;
+
+typedef struct {
+    const char *name;
+    encode_mode_t mode;
+    sensor_aq_float_encoding encoding;
+} encoding_t;
+
+static const encoding_t encodings[] = {
+    { "add_data", MODE_ADD_DATA, AQ_FLOAT_LOSSLESS },
+    { "compact_lossless", MODE_COMPACT, AQ_FLOAT_LOSSLESS },
+    { "compact_half", MODE_COMPACT, AQ_FLOAT_HALF },
+    { "frames_lossless", MODE_FRAMES, AQ_FLOAT_LOSSLESS },
+    { "frames_half", MODE_FRAMES, AQ_FLOAT_HALF },
+    { "frames_i16", MODE_FRAMES_I16, AQ_FLOAT_LOSSLESS },
+};
+
+typedef struct {
+    uint32_t frames;
+    uint32_t block;
+    uint32_t runs;
+    bool idle;
+} options_t;
+
+/* In memory stream ---------------------------------------------------------*/
+
+static std::vector<uint8_t> stream_data;
+
+static size_t stream_write(const void *buffer, size_t size, size_t count, EI_SENSOR_AQ_STREAM *)
+{
+    const uint8_t *bytes = (const uint8_t *)buffer;
+    stream_data.insert(stream_data.end(), bytes, bytes + size * count);
+    return count;
+}
+
+static int stream_seek(EI_SENSOR_AQ_STREAM *, long int, int)
+{
+    return 0;
+}
+
+static time_t stream_time(time_t *t)
+{
+    return 0;
+}
+
+/* Test data ----------------------------------------------------------------*/
+
+/**
+ * Raw counts of a board that is moved around (or lies still with `idle`),
+ * converted to m/s2 like ei_fusion_inertial_sensor_read_data()
+ */
+static void make_samples(const options_t *options, std::vector<int16_t> &counts, std::vector<float> &values)
+{
+    uint32_t random = 1;
+
+    counts.resize(options->frames * AXES);
+    values.resize(options->frames * AXES);
+
+    for(uint32_t frame = 0; frame < options->frames; frame++) {
+        float t = frame / 62.5f;
+
+        for(uint32_t axis = 0; axis < AXES; axis++) {
+            random = random * 1664525u + 1013904223u;
+            float noise = (float)((int32_t)(random >> 16) % 40 - 20);
+            float motion = options->idle ? 0.0f : 6000.0f * sinf(2.0f * 3.14159265f * (1.0f + axis) * t);
+            float gravity = axis == 2 ? 16384.0f : 0.0f;
+            int16_t count = (int16_t)fmaxf(-32768.0f, fminf(32767.0f, gravity + motion + noise));
+
+            counts[frame * AXES + axis] = count;
+            values[frame * AXES + axis] = (count / IMU_SCALING_CONST) * CONVERT_G_TO_MS2;
+        }
+    }
+}
+
+/* Decoding -----------------------------------------------------------------*/
+
+/**
+ * Decode one CBOR number (int, float16, float32, float64) at `ix`
+ */
+static bool decode_value(const std::vector<uint8_t> &data, size_t *ix, float *value)
+{
+    uint8_t head = data[(*ix)++];
+    uint8_t major = head >> 5;
+    uint8_t minor = head & 0x1f;
+    uint64_t arg = minor;
+
+    if(minor >= 24 && minor <= 27) {
+        size_t len = 1 << (minor - 24);
+        arg = 0;
+        for(size_t b = 0; b < len; b++) {
+            arg = (arg << 8) | data[(*ix)++];
+        }
+    }
+
+    if(major == 0) {
+        *value = (float)arg;
+    }
+    else if(major == 1) {
+        *value = -1.0f - (float)arg;
+    }
+    else if(major == 7 && minor == 25) {
+        *value = IEEE754_HalfToFloat((uint16_t)arg);
+    }
+    else if(major == 7 && minor == 26) {
+        uint32_t bits = (uint32_t)arg;
+        memcpy(value, &bits, sizeof(float));
+    }
+    else if(major == 7 && minor == 27) {
+        double d;
+        memcpy(&d, &arg, sizeof(double));
+        *value = (float)d;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Compare the values array that follows the header with what was encoded,
+ * returns the largest error in m/s2 (or -1 if the stream doesn't decode)
+ */
+static float decode_error(const std::vector<uint8_t> &data, size_t ix,
+    const std::vector<float> &expected, bool counts)
+{
+    float max_error = 0.0f;
+
+    for(size_t frame = 0; frame < expected.size() / AXES; frame++) {
+        if(ix >= data.size() || data[ix++] != (0x80 | AXES)) {
+            return -1.0f;
+        }
+        for(size_t axis = 0; axis < AXES; axis++) {
+            float value;
+            if(!decode_value(data, &ix, &value)) {
+                return -1.0f;
+            }
+            if(counts) {
+                value = (value / IMU_SCALING_CONST) * CONVERT_G_TO_MS2;
+            }
+            max_error = fmaxf(max_error, fabsf(value - expected[frame * AXES + axis]));
+        }
+    }
+
+    return ix == data.size() ? max_error : -1.0f;
+}
+
+/* Benchmark ----------------------------------------------------------------*/
+
+static int encode(const options_t *options, const encoding_t *encoding, sensor_aq_ctx *ctx,
+    std::vector<int16_t> &counts, std::vector<float> &values)
+{
+    for(uint32_t frame = 0; frame < options->frames; ) {
+        uint32_t count = options->block;
+        if(count > options->frames - frame) {
+            count = options->frames - frame;
+        }
+
+        int ret = AQ_OK;
+        switch(encoding->mode) {
+            case MODE_ADD_DATA:
+                for(uint32_t ix = 0; ix < count && ret == AQ_OK; ix++) {
+                    ret = sensor_aq_add_data(ctx, &values[(frame + ix) * AXES], AXES);
+                }
+                break;
+            case MODE_COMPACT:
+                for(uint32_t ix = 0; ix < count && ret == AQ_OK; ix++) {
+                    ret = sensor_aq_add_data_compact(ctx, &values[(frame + ix) * AXES], AXES, encoding->encoding);
+                }
+                break;
+            case MODE_FRAMES:
+                ret = sensor_aq_add_frames(ctx, &values[frame * AXES], count, AXES, encoding->encoding);
+                break;
+            case MODE_FRAMES_I16:
+                ret = sensor_aq_add_frames_i16(ctx, &counts[frame * AXES], count, AXES);
+                break;
+        }
+        if(ret != AQ_OK) {
+            return ret;
+        }
+        frame += count;
+    }
+
+    return sensor_aq_flush(ctx);
+}
+
+static bool run(const options_t *options, const encoding_t *encoding,
+    std::vector<int16_t> &counts, std::vector<float> &values, bool last)
+{
+    static unsigned char buffer[1024];  // same as the sampler
+    sensor_aq_signing_ctx_t signing_ctx;
+    sensor_aq_ctx ctx = { { buffer, sizeof(buffer) }, &signing_ctx, &stream_write, &stream_seek, &stream_time };
+    sensor_aq_payload_info payload = { "benchmark", "HOST", 16.0f, { { "accX", "m/s2" }, { "accY", "m/s2" }, { "accZ", "m/s2" } } };
+    double best_ns = 0.0;
+    uint64_t best_cycles = 0;
+    size_t header = 0;
+
+    sensor_aq_init_none_context(&signing_ctx);
+
+    for(uint32_t run = 0; run < options->runs; run++) {
+        stream_data.clear();
+        stream_data.reserve(options->frames * AXES * 10 + 1024);
+
+        int ret = sensor_aq_init(&ctx, &payload, (EI_SENSOR_AQ_STREAM *)&stream_data, false);
+        if(ret != AQ_OK) {
+            fprintf(stderr, "ERR: sensor_aq_init failed (%d)\n", ret);
+            return false;
+        }
+        header = stream_data.size();
+
+        auto start = std::chrono::steady_clock::now();
+#if HAS_CYCLE_COUNTER
+        uint64_t start_cycles = __rdtsc();
+#endif
+        ret = encode(options, encoding, &ctx, counts, values);
+#if HAS_CYCLE_COUNTER
+        uint64_t cycles = __rdtsc() - start_cycles;
+#else
+        uint64_t cycles = 0;
+#endif
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if(ret != AQ_OK) {
+            fprintf(stderr, "ERR: %s failed (%d)\n", encoding->name, ret);
+            return false;
+        }
+
+        if(run == 0 || ns < best_ns) {
+            best_ns = ns;
+            best_cycles = cycles;
+        }
+    }
+
+    float error = decode_error(stream_data, header, values, encoding->mode == MODE_FRAMES_I16);
+    if(error < 0.0f) {
+        fprintf(stderr, "ERR: %s wrote a stream that doesn't decode\n", encoding->name);
+        return false;
+    }
+
+    printf("    { \"encoding\": \"%s\", \"bytes_per_frame\": %.2f, \"ns_per_frame\": %.1f, ",
+        encoding->name, (double)(stream_data.size() - header) / options->frames, best_ns / options->frames);
+#if HAS_CYCLE_COUNTER
+    printf("\"tsc_cycles_per_frame\": %.1f, ", (double)best_cycles / options->frames);
+#endif
+    printf("\"max_error\": %.6f }%s\n", error, last ? "" : ",");
+    return true;
+}
+
+static void print_usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --frames N    3-axis frames to encode (default 10000)\n"
+        "  --block N     frames per sensor_aq_add_frames() call (default 32)\n"
+        "  --runs N      runs per encoding, the fastest is reported (default 5)\n"
+        "  --idle        board lying still instead of moving\n",
+        name);
+}
+
+int main(int argc, char **argv)
+{
+    options_t options = { 10000, 32, 5, false };
+
+    for(int ix = 1; ix < argc; ix++) {
+        const char *arg = argv[ix];
+        const bool has_value = ix + 1 < argc;
+
+        if(strcmp(arg, "--frames") == 0 && has_value) {
+            options.frames = strtoul(argv[++ix], NULL, 0);
+        }
+        else if(strcmp(arg, "--block") == 0 && has_value) {
+            options.block = strtoul(argv[++ix], NULL, 0);
+        }
+        else if(strcmp(arg, "--runs") == 0 && has_value) {
+            options.runs = strtoul(argv[++ix], NULL, 0);
+        }
+        else if(strcmp(arg, "--idle") == 0) {
+            options.idle = true;
+        }
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(options.frames == 0 || options.block == 0 || options.runs == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<int16_t> counts;
+    std::vector<float> values;
+    make_samples(&options, counts, values);
+
+    bool ok = true;
+    const size_t encoding_count = sizeof(encodings) / sizeof(encodings[0]);
+
+    printf("{\n  \"frames\": %u,\n  \"block\": %u,\n  \"idle\": %s,\n  \"sensor_lsb\": %.6f,\n  \"results\": [\n",
+        options.frames, options.block, options.idle ? "true" : "false", CONVERT_G_TO_MS2 / IMU_SCALING_CONST);
+    for(size_t ix = 0; ix < encoding_count; ix++) {
+        ok &= run(&options, &encodings[ix], counts, values, ix + 1 == encoding_count);
+    }
+    printf("  ]\n}\n");
+
+    return ok ? 0 : 1;
+}